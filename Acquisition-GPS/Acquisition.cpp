@@ -21,227 +21,1098 @@
 #include <fstream>
 #include <fftw3.h>
 #include <algorithm>
-#include "matplotlibcpp.h"
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+#include <type_traits>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <memory>
+#include <functional>
+#include <limits>
+#include "Acquisition.h"
+#include "Goldencodes.h"
+#include "FftPlanCache.h"
+#include "WorkStealingPool.h"
+#include "CarrierNco.h"
+#include "Resampler.h"
+#include "PeakDetector.h"
+#include "NpyFile.h"
+#include "BitCorrelator.h"
+#include "Metrics.h"
 
-namespace plt = matplotlibcpp;
 namespace fs = std::filesystem;
 
-class AcqResults {
-public:
-    std::vector<std::vector<std::vector<double>>> searchSpace; // Search space
-    std::vector<double> carrFreq;    // Carrier frequencies of detected signals
-    std::vector<double> codeDelay;  // Code delays of detected signals
-    std::vector<double> peakMetric; // Correlation peak ratios
-    std::vector<double> SNR;        // Signal-to-Noise ratio
+// Initialize the acquisition results
+void AcqResults::initialize(const Settings& settings, double searchSamplingFreq) {
+    this->searchSamplingFreq = searchSamplingFreq;
+    size_t samplesPerCode = static_cast<size_t>(
+        std::round(searchSamplingFreq * settings.codeLength / settings.codeFreqBasis));
 
-    // Initialize the acquisition results
-    void initialize(const Settings& settings) {
-        size_t samplesPerCode = static_cast<size_t>(
-            std::round(settings.samplingFreq * settings.codeLength / settings.codeFreqBasis));
+    size_t nFrqBins = acquisitionFrequencyBins(settings).size();
 
-        size_t nFrqBins = static_cast<size_t>(std::round(settings.acqFreqRangekHz * 8)) + 1;
+    // Results are indexed by PRN number
+    size_t numSatellites = *std::max_element(settings.satMask.begin(), settings.satMask.end()) + 1;
 
-        size_t numSatellites = settings.satMask.size() + 1;
+    searchSpace.initialize(parseSearchSpaceStorage(settings.acqSearchSpaceStorage), settings.satMask, nFrqBins,
+                           samplesPerCode);
+    carrFreq.resize(numSatellites, 0.0);
+    codeDelay.resize(numSatellites, 0.0);
+    peakMetric.resize(numSatellites, 0.0);
+    SNR.resize(numSatellites, 0.0);
+    acquired.resize(numSatellites, 0);
+}
+
+// Detection decision of one PRN from the summaries of its search space rows. The peak metric is
+// the SoftGNSS one: highest peak over the highest peak of the same frequency bin at least one
+// chip away. C/N0 is the excess power of the peak over the noise floor, per second of coherent
+// integration; the noise floor is taken without the code sidelobes of the signal, whose mean power
+// over the code period is 1 / codeLength of the peak. Near acqTh only peaks raised by the noise
+// pass, so the C/N0 of weak signals reads high (+1 to +2 dB at 42-43 dB-Hz with the default
+// search); resampled searches read about 0.5 dB low from their coarser delay grid.
+void AcqResults::detect(int PRN, const Settings& settings, const std::vector<double>& frqBins) {
+    SearchPeakSummary best = searchSpace.peak(PRN);
+    const SearchRowSummary& row = searchSpace.rowSummary(PRN, best.bin);
 
-        searchSpace.resize(numSatellites, std::vector<std::vector<double>>(nFrqBins, std::vector<double>(samplesPerCode, 0.0)));
-        carrFreq.resize(numSatellites, 0.0);
-        codeDelay.resize(numSatellites, 0.0);
-        peakMetric.resize(numSatellites, 0.0);
-        SNR.resize(numSatellites, 0.0);
+    peakMetric[PRN] = row.secondPeak > 0.0 ? row.peak / row.secondPeak : 0.0;
+
+    // Only acquired signals get a carrier frequency, code delay and C/N0
+    acquired[PRN] = peakMetric[PRN] > settings.acqTh;
+    if (!acquired[PRN]) {
+        SNR[PRN] = 0.0;
+        return;
     }
+    carrFreq[PRN] = frqBins[best.bin];
+    codeDelay[PRN] = delayInInputSamples(best.delay, settings);
 
-    // Plot the acquisition results
-    void plot(const Settings& settings, size_t samplesPerCode, size_t nFrqBins) {
-        std::string figspath = fs::path(settings.inputFile).parent_path().string() + "/SW-RCVR-C++/";
+    double coherentTime = settings.acqCoherentMs * settings.codeLength / settings.codeFreqBasis;
+    double noise = (row.noiseMean - row.peak / settings.codeLength) / (1.0 - 1.0 / settings.codeLength);
+    double carrierToNoise = noise > 0.0 ? (row.peak - noise) / (noise * coherentTime) : 0.0;
+    SNR[PRN] = carrierToNoise > 0.0 ? 10 * std::log10(carrierToNoise) : 0.0;
+}
 
-        if (!fs::exists(figspath)) {
-            fs::create_directories(figspath);
-        }
+// Dump the search space, downsampled, and the detection metrics for plotting
+void AcqResults::dump(const Settings& settings, const std::string& dir) const {
+    METRICS_STAGE(ResultsOutput);
+    if (!fs::exists(dir)) {
+        fs::create_directories(dir);
+    }
 
-        for (size_t PRN = 1; PRN < settings.satMask.size() + 1; ++PRN) {
-            std::vector<std::vector<double>> prnSearchSpace = searchSpace[PRN];
+    writeNpy(dir + "ACQUISITION_METRIC.npy", peakMetric.data(), {peakMetric.size()});
+    writeNpy(dir + "SNR.npy", SNR.data(), {SNR.size()});
 
-            std::vector<double> frequencies(nFrqBins);
-            for (size_t i = 0; i < nFrqBins; ++i) {
-                frequencies[i] = -settings.acqFreqRangekHz / 2 + 0.125 * i;
-            }
+    // Surfaces can only be dumped if they were kept
+    if (!searchSpace.hasSurface()) {
+        return;
+    }
+
+    // Every output cell is the maximum of its group of bins and delays, so peaks survive
+    size_t nFrqBins = searchSpace.numBins();
+    size_t samplesPerCode = searchSpace.samplesPerCode();
+    size_t outBins = settings.acqDumpBins > 0 ? std::min<size_t>(settings.acqDumpBins, nFrqBins) : nFrqBins;
+    size_t outDelays = settings.acqDumpDelays > 0 ? std::min<size_t>(settings.acqDumpDelays, samplesPerCode)
+                                                  : samplesPerCode;
+    auto binGroup = [&](size_t i) { return i * nFrqBins / outBins; };
+    auto delayGroup = [&](size_t i) { return i * samplesPerCode / outDelays; };
 
-            std::vector<double> delays(samplesPerCode);
-            for (size_t i = 0; i < samplesPerCode; ++i) {
-                delays[i] = i * settings.codeFreqBasis / settings.samplingFreq;
+    // Axes: mean Doppler of each bin group [kHz] and first code delay of each delay group [chips]
+    std::vector<double> frqBins = acquisitionFrequencyBins(settings);
+    std::vector<double> frequencies(outBins), delays(outDelays);
+    for (size_t i = 0; i < outBins; ++i) {
+        double sum = 0.0;
+        for (size_t bin = binGroup(i); bin < binGroup(i + 1); ++bin) {
+            sum += frqBins[bin] - settings.IF;
+        }
+        frequencies[i] = sum / (binGroup(i + 1) - binGroup(i)) / 1000;
+    }
+    for (size_t i = 0; i < outDelays; ++i) {
+        delays[i] = delayGroup(i) * settings.codeFreqBasis / searchSamplingFreq;
+    }
+    writeNpy(dir + "SEARCH_SPACE_FREQUENCIES.npy", frequencies.data(), {outBins});
+    writeNpy(dir + "SEARCH_SPACE_DELAYS.npy", delays.data(), {outDelays});
+
+    std::vector<double> row(samplesPerCode);
+    std::vector<float> surface(outBins * outDelays);
+    for (int PRN : settings.satMask) {
+        std::fill(surface.begin(), surface.end(), 0.0f);
+        for (size_t i = 0; i < outBins; ++i) {
+            float* out = surface.data() + i * outDelays;
+            for (size_t bin = binGroup(i); bin < binGroup(i + 1); ++bin) {
+                searchSpace.row(PRN, bin, row.data());
+                for (size_t j = 0; j < outDelays; ++j) {
+                    double groupMax = *std::max_element(row.begin() + delayGroup(j), row.begin() + delayGroup(j + 1));
+                    out[j] = std::max(out[j], static_cast<float>(groupMax));
+                }
             }
+        }
+        writeNpy(dir + "SEARCH_SPACE_PRN" + std::to_string(PRN) + ".npy", surface.data(), {outBins, outDelays});
+    }
+}
 
-            plt::figure();
-            plt::plot_surface(frequencies, delays, prnSearchSpace, {
-                {"cmap", "coolwarm"},
-                {"antialiased", false}
-            });
+std::string acquisitionOutputDir(const Settings& settings) {
+    return fs::path(settings.inputFile).parent_path().string() + "/SW-RCVR-C++/";
+}
+
+int nextPowerOf2(int n) {
+    return pow(2, ceil(log2(n)));
+}
 
-            plt::title("PRN " + std::to_string(PRN) + " Search Space");
-            plt::xlabel("Doppler Frequency [kHz]");
-            plt::ylabel("Code Delay");
-            plt::grid(true, "--", 0.5);
+// Frequency-domain C/A code replica of one PRN (conjugated, ready for correlation)
+template <typename T>
+static std::vector<std::complex<T>> codeReplicaFreqDom(int PRN, const std::vector<int>& codeOversampIdx,
+                                                       typename Fftw<T>::Complex* codeArr,
+                                                       typename Fftw<T>::Complex* codeFreqDomArr) {
+    int samplesPerCode = codeOversampIdx.size();
+    const auto& caCodeReplica = caCodeTable.chips.at(PRN);
 
-            plt::save(figspath + "SEARCH_SPACE_PRN" + std::to_string(PRN) + ".png");
-            plt::close();
-        }
+    // Digitizing the C/A code
+    for (int i = 0; i < samplesPerCode; ++i) {
+        codeArr[i][0] = caCodeReplica[codeOversampIdx[i]];
+        codeArr[i][1] = 0;
+    }
+    Fftw<T>::execute(Fftw<T>::plan(samplesPerCode, FFTW_FORWARD), codeArr, codeFreqDomArr);
 
-        plotBar(settings, "Acquisition Metric", peakMetric, figspath + "ACQUISITION_METRIC.png");
-        plotBar(settings, "Signal to Noise Ratio [dB-Hz]", SNR, figspath + "SNR.png", true);
+    std::vector<std::complex<T>> caCodeReplicaFreqDom(samplesPerCode);
+    for (int i = 0; i < samplesPerCode; ++i) {
+        caCodeReplicaFreqDom[i] = std::conj(std::complex<T>(codeFreqDomArr[i][0], codeFreqDomArr[i][1]));
     }
+    return caCodeReplicaFreqDom;
+}
+
+// Code spectra are kept for the whole process, like the FFTW plans: every search with the same
+// PRN, code length, search sampling frequency and code rate (batch jobs, streaming searches)
+// shares one copy. The map never moves its elements, so references stay valid.
+template <typename T>
+static const std::vector<std::complex<T>>& sharedCodeSpectrum(int PRN, const std::vector<int>& codeOversampIdx,
+                                                               double searchSamplingFreq, double codeFreqBasis) {
+    using Key = std::tuple<int, size_t, double, double>;
+    static std::mutex mutex;
+    static std::map<Key, std::vector<std::complex<T>>> spectra;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Key key(PRN, codeOversampIdx.size(), searchSamplingFreq, codeFreqBasis);
+    auto found = spectra.find(key);
+    if (found == spectra.end()) {
+        typename Fftw<T>::Buffer codeArr = Fftw<T>::alloc(codeOversampIdx.size());
+        typename Fftw<T>::Buffer codeFreqDomArr = Fftw<T>::alloc(codeOversampIdx.size());
+        found = spectra.emplace(key, codeReplicaFreqDom<T>(PRN, codeOversampIdx, codeArr.get(), codeFreqDomArr.get()))
+                    .first;
+    }
+    return found->second;
+}
+
+// Reject integration settings the search cannot run with
+static void checkIntegration(const Settings& settings) {
+    if (settings.acqCoherentMs < 1 || settings.acqCoherentMs > 10) {
+        throw std::invalid_argument("acqCoherentMs must be between 1 and 10 ms");
+    }
+    if (settings.acqNonCoherentSums < 1) {
+        throw std::invalid_argument("acqNonCoherentSums must be at least 1");
+    }
+    if (settings.acqFreqStepHz <= 0) {
+        throw std::invalid_argument("acqFreqStepHz must be positive");
+    }
+}
+
+// Search step [Hz]: the step shrinks with the coherent integration time so the worst-case
+// frequency error costs the same correlation loss as acqFreqStepHz does for 1 ms
+static double acquisitionBinStep(const Settings& settings) {
+    return settings.acqFreqStepHz / settings.acqCoherentMs;
+}
+
+// Integrate-and-dump intervals per code period of the fine frequency stage. Squaring the dumps
+// doubles the frequency, so the dump rate must exceed 4 bin steps for a peak found one bin away
+// from the true frequency (weak signals) to stay unambiguous.
+static int fineDumpsPerCode(const Settings& settings) {
+    double codePeriodRate = settings.codeFreqBasis / settings.codeLength;
+    return static_cast<int>(4 * acquisitionBinStep(settings) / codePeriodRate) + 1;
+}
+
+static void checkFineFrequency(const Settings& settings) {
+    if (settings.acqFineFrequency
+        && (settings.acqFineMs < 1 || settings.acqFineFftSize < settings.acqFineMs * fineDumpsPerCode(settings))) {
+        throw std::invalid_argument("acqFineMs must be at least 1 and acqFineFftSize at least "
+                                    + std::to_string(fineDumpsPerCode(settings)) + " x acqFineMs");
+    }
+}
+
+// Code periods of search signal the correlation and the fine frequency stage read
+static int acquisitionCodePeriods(const Settings& settings) {
+    int periods = 2 * settings.acqNonCoherentSums * settings.acqCoherentMs;
+    return settings.acqFineFrequency ? std::max(periods, settings.acqFineMs) : periods;
+}
+
+std::vector<double> acquisitionFrequencyBins(const Settings& settings) {
+    double binStep = acquisitionBinStep(settings);
+    int nFrqBins = std::lround(settings.acqFreqRangekHz * 1000 / binStep) + 1;
+
+    std::vector<double> frqBins(nFrqBins);
+    for (int frqBinIndex = 0; frqBinIndex < nFrqBins; ++frqBinIndex) {
+        frqBins[frqBinIndex] = settings.IF - (settings.acqFreqRangekHz / 2) * 1000 + binStep * frqBinIndex;
+    }
+    return frqBins;
+}
+
+double searchSamplingFrequency(const Settings& settings) {
+    if (!settings.acqResample) {
+        return settings.samplingFreq;
+    }
+    int resampledSamplesPerCode = settings.acqResampledSamplesPerCode > 0 ? settings.acqResampledSamplesPerCode
+                                                                          : nextPowerOf2(4 * settings.codeLength);
+    return resampledSamplesPerCode * settings.codeFreqBasis / settings.codeLength;
+}
+
+double searchCarrierOffset(const Settings& settings) {
+    return settings.acqResample ? settings.IF : 0.0;
+}
 
-private:
-    // Helper function for bar plots
-    void plotBar(const Settings& settings, const std::string& title, const std::vector<double>& data, const std::string& filepath, bool limitY = false) {
-        std::vector<double> x;
-        for (size_t i = 1; i <= settings.satMask.size(); ++i) {
-            x.push_back(static_cast<double>(i));
+size_t searchSignalSampleCount(const Settings& settings) {
+    checkIntegration(settings);
+    size_t samplesPerCode = static_cast<size_t>(
+        std::round(searchSamplingFrequency(settings) * settings.codeLength / settings.codeFreqBasis));
+    return acquisitionCodePeriods(settings) * samplesPerCode;
+}
+
+size_t acquisitionSampleCount(const Settings& settings) {
+    checkIntegration(settings);
+    size_t samplesPerCode = static_cast<size_t>(
+        std::round(settings.samplingFreq * settings.codeLength / settings.codeFreqBasis));
+    size_t count = acquisitionCodePeriods(settings) * samplesPerCode;
+
+    // The resampling filter reads half its length past the last output
+    if (settings.acqResample) {
+        count += settings.acqResampleTaps / 2 + 1;
+    }
+    return count;
+}
+
+// GPS L1 carrier frequency [Hz], for the code Doppler of warm-start code delay predictions
+constexpr double gpsL1Frequency = 1575.42e6;
+
+// Warm-start code delay windows are searched in the time domain when they have at most this many
+// delays per log2(samplesPerCode): the measured break-even against the DFT search of a whole code
+// period, which FFTW transforms about 3 times slower per point for lengths that are not a power
+// of two
+constexpr double timeDomainDelaysPerLog2 = 3.0;
+constexpr double timeDomainDelaysPerLog2Mixed = 10.0;
+
+// Same break-even for the bit-packed correlator (acqPackedBits), which does 64 samples per word
+// operation
+constexpr double packedDelaysPerLog2 = 12.0;
+constexpr double packedDelaysPerLog2Mixed = 40.0;
+
+// Delays around the peak of a bit-packed window measured again with the floating-point correlator
+// (the packed peak may be a sample off the floating-point one)
+constexpr int packedPeakDelays = 3;
+
+namespace {
+
+// convCodeIQ[i] = signalFreqDom[(i + shift) % n] * codeFreqDom[i]; a shift of k DFT bins is the
+// spectrum of the signal mixed down by k more bins
+template <typename T>
+void multiplySpectra(const std::complex<T>* signalFreqDom, int shift, const std::complex<T>* codeFreqDom,
+                     std::complex<T>* convCodeIQ, int n) {
+    for (int i = 0; i < n - shift; ++i) {
+        convCodeIQ[i] = signalFreqDom[i + shift] * codeFreqDom[i];
+    }
+    for (int i = n - shift; i < n; ++i) {
+        convCodeIQ[i] = signalFreqDom[i + shift - n] * codeFreqDom[i];
+    }
+}
+
+// Coherent integration of numBlocks blocks of coherentMs code periods: the correlation of a
+// block with the code repeated coherentMs times only has energy on every coherentMs-th bin of
+// the block spectrum, and that bin is the sum of the spectra of the 1 ms sub-blocks. So
+// out[b] = sum of the coherentMs 1 ms spectra of block b, and the correlation needs a single
+// 1 ms inverse DFT per block.
+template <typename T>
+void sumSubSpectra(const std::complex<T>* subSpectra, std::complex<T>* out, int numBlocks, int coherentMs,
+                   int samplesPerCode) {
+    for (int block = 0; block < numBlocks; ++block) {
+        const std::complex<T>* in = subSpectra + size_t(block) * coherentMs * samplesPerCode;
+        std::complex<T>* sum = out + size_t(block) * samplesPerCode;
+        std::copy(in, in + samplesPerCode, sum);
+        for (int ms = 1; ms < coherentMs; ++ms) {
+            const std::complex<T>* sub = in + size_t(ms) * samplesPerCode;
+            for (int i = 0; i < samplesPerCode; ++i) {
+                sum[i] += sub[i];
+            }
         }
+    }
+}
+
+// Per-worker correlation buffers. Blocks 0..numSums-1 are the first candidate set and blocks
+// numSums..2*numSums-1 the second one. The fine frequency buffers are only allocated when the
+// fine stage runs.
+template <typename T>
+struct CorrelatorScratch {
+    typename Fftw<T>::Buffer IQArr, subSpectraArr, coherentSpectraArr, convCodeIQArr, acqResArr;
+    std::vector<T> acqRes1, acqRes2;
+    RowPeakDetector<T> detector1, detector2;
+    std::vector<std::complex<T>> fineRecord;
+    typename Fftw<T>::Buffer fineArr, fineSpectrumArr;
+    std::vector<std::complex<T>> windowCorrelation;  // Time-domain search, numBlocks x numDelays
+    std::vector<T> windowPower1, windowPower2;
+    PackedSamples packedIQ;  // IQArr quantized for the bit-packed correlator
 
-        plt::figure();
-        plt::bar(x, std::vector<double>(data.begin() + 1, data.end()));
-        plt::title(title);
-        plt::xlabel("PRN number (no bar - SV is not in the acquisition list)");
-        plt::ylabel(title);
-        plt::grid(true, "--", 0.5);
+    CorrelatorScratch(int samplesPerCode, int samplesPerCodeChip, int numBlocks, int coherentMs)
+        : IQArr(Fftw<T>::alloc(size_t(numBlocks) * coherentMs * samplesPerCode)),
+          subSpectraArr(Fftw<T>::alloc(size_t(numBlocks) * coherentMs * samplesPerCode)),
+          coherentSpectraArr(Fftw<T>::alloc(size_t(numBlocks) * samplesPerCode)),
+          convCodeIQArr(Fftw<T>::alloc(size_t(numBlocks) * samplesPerCode)),
+          acqResArr(Fftw<T>::alloc(size_t(numBlocks) * samplesPerCode)),
+          acqRes1(samplesPerCode), acqRes2(samplesPerCode),
+          detector1(samplesPerCode, samplesPerCodeChip), detector2(samplesPerCode, samplesPerCodeChip) {}
+};
 
-        if (limitY) {
-            plt::ylim(20, *std::max_element(data.begin() + 1, data.end()));
+// Time-domain correlation of every block with the code replica at numDelays consecutive delays
+// from firstDelay (circular): out[block * numDelays + d]. codeTwice holds two code periods with
+// every chip value repeated for I and Q, so the replica at a delay multiplies the interleaved IQ
+// samples element by element: code[(i - delay) mod samplesPerCode] for sample i is at
+// codeTwice[2 * (samplesPerCode - delay + i)]. The products are summed in correlationLanes
+// independent partial sums (even lanes I, odd lanes Q) the compiler keeps in vector registers.
+// Scaled by samplesPerCode like the inverse DFT of the frequency-domain correlation, so both
+// searches give the same |correlation|^2.
+constexpr int correlationLanes = 16;
+
+template <typename T>
+void correlateDelays(const std::complex<T>* IQ, int numBlocks, int coherentMs, int samplesPerCode,
+                     const T* codeTwice, int firstDelay, int numDelays, std::complex<T>* out) {
+    int numValues = 2 * samplesPerCode;
+    int vectorValues = numValues / correlationLanes * correlationLanes;
+    for (int block = 0; block < numBlocks; ++block) {
+        const T* blockIQ = reinterpret_cast<const T*>(IQ + size_t(block) * coherentMs * samplesPerCode);
+        for (int d = 0; d < numDelays; ++d) {
+            const T* code = codeTwice + 2 * (samplesPerCode - (firstDelay + d) % samplesPerCode);
+            T lanes[correlationLanes] = {};
+            for (int ms = 0; ms < coherentMs; ++ms) {
+                const T* x = blockIQ + size_t(numValues) * ms;
+                for (int i = 0; i < vectorValues; i += correlationLanes) {
+                    for (int lane = 0; lane < correlationLanes; ++lane) {
+                        lanes[lane] += x[i + lane] * code[i + lane];
+                    }
+                }
+                for (int i = vectorValues; i < numValues; ++i) {
+                    lanes[i % 2] += x[i] * code[i];
+                }
+            }
+
+            T re = 0, im = 0;
+            for (int lane = 0; lane < correlationLanes; lane += 2) {
+                re += lanes[lane];
+                im += lanes[lane + 1];
+            }
+            out[size_t(block) * numDelays + d] = std::complex<T>(re, im) * T(samplesPerCode);
         }
+    }
+}
 
-        plt::save(filepath);
-        plt::close();
+// out[d] = sum over k < numSums of |x[k * numDelays + d]|^2
+template <typename T>
+void accumulateWindow(const std::complex<T>* x, int numSums, int numDelays, T* out) {
+    for (int d = 0; d < numDelays; ++d) {
+        T value = 0;
+        for (int k = 0; k < numSums; ++k) {
+            value += std::norm(x[size_t(k) * numDelays + d]);
+        }
+        out[d] = value;
     }
+}
+
+// Part of the search space one PRN is searched over: frequency bins [firstBin, lastBin) and,
+// for a time-domain search, numDelays code delays from firstDelay, with the whole code period
+// searched at referenceBin for the noise statistics
+struct PrnWindow {
+    int firstBin = 0, lastBin = 0;
+    bool timeDomain = false;
+    int firstDelay = 0, numDelays = 0;
+    int referenceBin = 0;
+
+    bool contains(int bin) const { return bin >= firstBin && bin < lastBin; }
+};
+
+template <typename T>
+std::complex<T>* asComplex(typename Fftw<T>::Complex* buffer) {
+    return reinterpret_cast<std::complex<T>*>(buffer);
+}
+
+// Search signal in precision T; storage owns the samples when they had to be converted or
+// resampled, otherwise the view points to the caller's samples
+template <typename T>
+struct PreparedSignal {
+    std::vector<std::complex<T>> storage;
+    SearchSignal<T> view;
 };
 
-int nextPowerOf2(int n) {
-    return pow(2, ceil(log2(n)));
 }
 
-AcqResults acquisitionGpsL1C(Settings& settings, std::vector<double>& inputSignal) {
-    int samplesPerCode = round((settings.samplingFreq * settings.codeLength) / settings.codeFreqBasis);
-    int samplesPerCodeChip = round(settings.samplingFreq / settings.codeFreqBasis);
-    std::vector<double> signal1(inputSignal.begin(), inputSignal.begin() + samplesPerCode);
-    std::vector<double> signal2(inputSignal.begin() + samplesPerCode, inputSignal.begin() + 2 * samplesPerCode);
-    std::vector<double> signal0DC(inputSignal.size());
-    double ts = 1 / settings.samplingFreq;
-    double tc = 1 / settings.codeFreqBasis;
+// Optional decimating front-end: mix the input to baseband and resample it so one code period is
+// a power-of-two number of samples. The input is converted to precision T while being copied.
+template <typename T, typename In>
+static PreparedSignal<T> prepareSearchSignal(const Settings& settings, const std::vector<std::complex<In>>& inputSignal) {
+    METRICS_STAGE(SignalPreparation);
+    PreparedSignal<T> prepared;
+    size_t numSamples = searchSignalSampleCount(settings);
 
-    // Create phase points
-    std::vector<double> phasePoints(samplesPerCode);
-    for (int i = 0; i < samplesPerCode; ++i) {
-        phasePoints[i] = 2 * i * M_PI * ts;
+    // The resampler would take the input missing under its filter as zeros
+    if (inputSignal.size() < acquisitionSampleCount(settings)) {
+        throw std::invalid_argument("The acquisition needs " + std::to_string(acquisitionSampleCount(settings)) +
+                                    " input samples");
     }
+    if (settings.acqResample) {
+        prepared.storage = basebandResample<T>(inputSignal, numSamples, settings.IF, settings.samplingFreq,
+                                               searchSamplingFrequency(settings), settings.acqResampleTaps);
+    } else {
+        prepared.storage.assign(inputSignal.begin(), inputSignal.begin() + numSamples);
+    }
+    METRICS_COUNT(BytesAllocated, prepared.storage.size() * sizeof(std::complex<T>));
+    prepared.view.samples = prepared.storage.data();
+    prepared.view.numSamples = numSamples;
+    prepared.view.samplingFreq = searchSamplingFrequency(settings);
+    prepared.view.carrierOffset = searchCarrierOffset(settings);
+    return prepared;
+}
 
-    int nFrqBins = round(settings.acqFreqRangekHz * 8) + 1;
+// A signal that already went through the front-end is used in place if it is in precision T
+template <typename T, typename U>
+static PreparedSignal<T> prepareSearchSignal(const Settings& settings, const SearchSignal<U>& searchSignal) {
+    size_t numSamples = searchSignalSampleCount(settings);
+    if (searchSignal.numSamples < numSamples || searchSignal.samplingFreq != searchSamplingFrequency(settings)
+        || searchSignal.carrierOffset != searchCarrierOffset(settings)) {
+        throw std::invalid_argument("Search signal does not match the acquisition settings");
+    }
 
-    std::vector<std::vector<double>> results(nFrqBins, std::vector<double>(samplesPerCode));
-    std::vector<double> frqBins(nFrqBins);
+    METRICS_STAGE(SignalPreparation);
+    PreparedSignal<T> prepared;
+    prepared.view = {nullptr, numSamples, searchSignal.samplingFreq, searchSignal.carrierOffset};
+    if constexpr (std::is_same_v<T, U>) {
+        prepared.view.samples = searchSignal.samples;
+    } else {
+        prepared.storage.assign(searchSignal.samples, searchSignal.samples + numSamples);
+        METRICS_COUNT(BytesAllocated, prepared.storage.size() * sizeof(std::complex<T>));
+        prepared.view.samples = prepared.storage.data();
+    }
+    return prepared;
+}
+
+// Doppler-major search: the carrier wipe-off and forward DFT of each signal block only depend
+// on the frequency bin, so they are computed once per bin and correlated against the code
+// spectra of every PRN in satMask. T is the precision of the whole search (samples, spectra
+// and FFTs); Input is the raw input signal or a signal that already went through the front-end.
+//
+// Two candidate sets of acqNonCoherentSums blocks of acqCoherentMs ms are searched and the set
+// with the highest peak is kept (a navigation bit edge spoils at most one of them). All blocks
+// of a bin go through one batched forward DFT and, per PRN, one batched inverse DFT; the power
+// of the blocks of a set is accumulated into its row while detecting the peak.
+//
+// With hints (warm start) each PRN is only searched over the bins within acqWarmFreqWindowHz of
+// its hint, and over acqWarmCodeWindowChips around its predicted code delay with a time-domain
+// correlation when that is cheaper than the DFT of the whole code period. With acqPackedBits
+// the time-domain correlation runs on 1- or 2-bit requantized samples (BitCorrelator.h).
+//
+// Tiles run on pool when there is one, else on a pool of acqThreads threads created for the search.
+template <typename T, typename Input>
+static AcqResults searchGpsL1CImpl(const Settings& settings, const Input& inputSignal,
+                                   const AcquisitionCallback& onPrnDone,
+                                   const std::vector<AcquisitionHint>* hints = nullptr,
+                                   WorkStealingPool* pool = nullptr) {
+    checkIntegration(settings);
+    int coherentMs = settings.acqCoherentMs;
+    int numSums = settings.acqNonCoherentSums;
+    int numBlocks = 2 * numSums;
+    int codePeriods = numBlocks * coherentMs;
+
+    PreparedSignal<T> prepared = prepareSearchSignal<T>(settings, inputSignal);
+    const std::complex<T>* signal = prepared.view.samples;
+    double searchSamplingFreq = prepared.view.samplingFreq;
+    double carrierOffset = prepared.view.carrierOffset;  // Frequency already removed from the searched signal
+
+    int samplesPerCode = round((searchSamplingFreq * settings.codeLength) / settings.codeFreqBasis);
+    int blockLength = coherentMs * samplesPerCode;
+
+    int samplesPerCodeChip = std::lround(searchSamplingFreq / settings.codeFreqBasis);
+    std::vector<double> frqBins = acquisitionFrequencyBins(settings);
+    int nFrqBins = frqBins.size();
+    double binStep = acquisitionBinStep(settings);
     std::vector<int> codeOversampIdx(samplesPerCode);
 
     // Initialize the index for oversampling
     for (int i = 0; i < samplesPerCode; ++i) {
-        codeOversampIdx[i] = ceil(ts * (i + 1) / tc) - 1;
+        codeOversampIdx[i] = caCodeChipIndex(i, searchSamplingFreq, settings.codeFreqBasis);
     }
     codeOversampIdx[samplesPerCode - 1] = settings.codeLength - 1;
 
     // Initialize AcqResults object
     AcqResults acqResults;
-    acqResults.initialize(settings);
+    acqResults.initialize(settings, searchSamplingFreq);
 
-    std::cout << "Acquiring GPS L1C ...\n(";
+    // Plans are cached across calls, so they are only created for the first samplesPerCode seen.
+    // New-array execution of a plan is thread-safe, so all workers share them.
+    FftPlanCache& planCache = FftPlanCache::instance();
+    planCache.configure(settings);
+    typename Fftw<T>::Plan fftPlan = Fftw<T>::planMany(samplesPerCode, codePeriods, FFTW_FORWARD);
+    typename Fftw<T>::Plan ifftPlan = Fftw<T>::planMany(samplesPerCode, numBlocks, FFTW_BACKWARD);
 
+    // Bank of code spectra, one per PRN in satMask
+    std::vector<const std::vector<std::complex<T>>*> codeBank;
+    codeBank.reserve(settings.satMask.size());
     for (int PRN : settings.satMask) {
-        std::vector<int> caCodeReplica = generateGoldCode(PRN);
+        codeBank.push_back(&sharedCodeSpectrum<T>(PRN, codeOversampIdx, searchSamplingFreq, settings.codeFreqBasis));
+    }
 
-        // Digitizing the C/A code
-        std::vector<int> caCodeReplicaOversamp(samplesPerCode);
-        for (int i = 0; i < samplesPerCode; ++i) {
-            caCodeReplicaOversamp[i] = caCodeReplica[codeOversampIdx[i]];
+    // Wipe off the carrier of frequency bin frqBinIndex from every block into IQArr
+    auto wipeOffBlocks = [&](int frqBinIndex, CorrelatorScratch<T>& buffers) {
+        METRICS_STAGE(CarrierWipeOff);
+        // Remove carrier from signal (demodulation): I = sin * signal, Q = cos * signal
+        std::vector<const std::complex<T>*> signals(numBlocks);
+        std::vector<std::complex<T>*> IQ(numBlocks);
+        for (int block = 0; block < numBlocks; ++block) {
+            signals[block] = signal + size_t(block) * blockLength;
+            IQ[block] = asComplex<T>(buffers.IQArr.get()) + size_t(block) * blockLength;
         }
+        carrierWipeOff(signals.data(), IQ.data(), numBlocks, blockLength, frqBins[frqBinIndex] - carrierOffset,
+                       searchSamplingFreq);
+    };
+
+    // Wipe off the carrier of frequency bin frqBinIndex and transform all 1 ms sub-blocks in one
+    // batch. Returns the coherent block spectra (subSpectra itself for 1 ms).
+    auto blockSpectra = [&](int frqBinIndex, CorrelatorScratch<T>& buffers) {
+        wipeOffBlocks(frqBinIndex, buffers);
 
-        // Perform DFT of C/A code
-        std::vector<std::complex<double>> caCodeReplicaFreqDom(samplesPerCode);
-        fftw_complex* caCodeReplicaFreqDomArr = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * samplesPerCode);
-        fftw_plan plan = fftw_plan_dft_1d(samplesPerCode, (fftw_complex*)caCodeReplicaOversamp.data(),
-                                          caCodeReplicaFreqDomArr, FFTW_BACKWARD, FFTW_ESTIMATE);
-        fftw_execute(plan);
-        for (int i = 0; i < samplesPerCode; ++i) {
-            caCodeReplicaFreqDom[i] = std::complex<double>(caCodeReplicaFreqDomArr[i][0], caCodeReplicaFreqDomArr[i][1]);
+        METRICS_STAGE(ForwardFft);
+        METRICS_COUNT(FftsExecuted, codePeriods);
+        Fftw<T>::execute(fftPlan, buffers.IQArr.get(), buffers.subSpectraArr.get());
+        if (coherentMs == 1) {
+            return asComplex<T>(buffers.subSpectraArr.get());
         }
+        sumSubSpectra(asComplex<T>(buffers.subSpectraArr.get()), asComplex<T>(buffers.coherentSpectraArr.get()),
+                      numBlocks, coherentMs, samplesPerCode);
+        return asComplex<T>(buffers.coherentSpectraArr.get());
+    };
+
+    // Circular-shift search: mixing by a whole number of DFT bins (searchSamplingFreq / samplesPerCode,
+    // 1 kHz for a 1 ms block) is a circular rotation of the spectrum, and it keeps the carrier phase
+    // continuous from one 1 ms sub-block to the next. Only the first numFineBins bins are wiped off
+    // and transformed; every other bin reuses one of those spectra, rotated.
+    bool circularShift = settings.acqCircularShiftSearch;
+    double dftBinSpacing = searchSamplingFreq / samplesPerCode;
+    int numFineBins = std::lround(dftBinSpacing / binStep);
+    if (circularShift && (numFineBins < 1 || std::abs(numFineBins * binStep - dftBinSpacing) > 1e-6)) {
+        std::cerr << "Warning: DFT bin spacing of " << dftBinSpacing << " Hz is not a multiple of the "
+                  << binStep << " Hz search step, using the time-domain search" << std::endl;
+        circularShift = false;
+    }
+    numFineBins = std::min(numFineBins, nFrqBins);
 
-        // Correlate signals for all frequency bins
-        for (int frqBinIndex = 0; frqBinIndex < nFrqBins; ++frqBinIndex) {
-            frqBins[frqBinIndex] = settings.IF - (settings.acqFreqRangekHz / 2) * 1000 + 125 * frqBinIndex;
-            std::vector<double> sinCarrReplica(samplesPerCode);
-            std::vector<double> cosCarrReplica(samplesPerCode);
+    // Search window of every PRN: the whole search space, or the part around its hint
+    int numPrns = settings.satMask.size();
+    std::vector<PrnWindow> windows(numPrns);
+    std::vector<std::vector<T>> windowCodes(numPrns);  // Code replicas of the time-domain PRNs
+    std::vector<PackedCode> packedCodes(numPrns);      // Same, for the bit-packed correlator
+    int packedBits = settings.acqPackedBits;
+    int maxWindowDelays = 0;
+    for (int prnIndex = 0; prnIndex < numPrns; ++prnIndex) {
+        PrnWindow& window = windows[prnIndex];
+        window.lastBin = nFrqBins;
+        window.numDelays = samplesPerCode;
+        if (!hints) {
+            continue;
+        }
+        const AcquisitionHint& hint = (*hints)[prnIndex];
 
-            // Generate local sine and cosine
-            for (int i = 0; i < samplesPerCode; ++i) {
-                sinCarrReplica[i] = sin(frqBins[frqBinIndex] * phasePoints[i]);
-                cosCarrReplica[i] = cos(frqBins[frqBinIndex] * phasePoints[i]);
+        int nearestBin = std::lround((hint.carrFreq - frqBins[0]) / binStep);
+        int halfBins = static_cast<int>(settings.acqWarmFreqWindowHz / binStep);
+        window.firstBin = std::clamp(nearestBin - halfBins, 0, nFrqBins);
+        window.lastBin = std::clamp(nearestBin + halfBins + 1, 0, nFrqBins);
+
+        // The code phase drifts by acqWarmSampleOffset samples plus the code Doppler over them
+        if (hint.codeDelay < 0 || settings.acqWarmCodeWindowChips <= 0) {
+            continue;
+        }
+        double codeDoppler = (hint.carrFreq - settings.IF) / gpsL1Frequency;
+        double inputDelay = hint.codeDelay - settings.acqWarmSampleOffset * (1 + codeDoppler);
+        double delay = std::fmod(inputDelay * searchSamplingFreq / settings.samplingFreq, samplesPerCode);
+        int halfDelays = std::ceil(settings.acqWarmCodeWindowChips * searchSamplingFreq / settings.codeFreqBasis);
+        int numDelays = 2 * halfDelays + 1;
+
+        // A delay costs samplesPerCode multiply-adds per code period (samplesPerCode / 64 word
+        // operations when packed)
+        bool powerOf2 = (samplesPerCode & (samplesPerCode - 1)) == 0;
+        double delaysPerLog2 = packedBits ? (powerOf2 ? packedDelaysPerLog2 : packedDelaysPerLog2Mixed)
+                                          : (powerOf2 ? timeDomainDelaysPerLog2 : timeDomainDelaysPerLog2Mixed);
+        if (numDelays <= delaysPerLog2 * std::log2(samplesPerCode)) {
+            window.timeDomain = true;
+            window.numDelays = numDelays;
+            window.referenceBin = std::clamp(nearestBin, window.firstBin, std::max(window.firstBin, window.lastBin - 1));
+            window.firstDelay = (static_cast<int>(std::lround(delay)) - halfDelays + 2 * samplesPerCode) % samplesPerCode;
+            maxWindowDelays = std::max(maxWindowDelays, numDelays);
+
+            // Packed windows keep the replica to measure their peak again
+            if (packedBits) {
+                packedCodes[prnIndex] = PackedCode(hint.PRN, codeOversampIdx);
             }
+            const auto& caCodeReplica = caCodeTable.chips.at(hint.PRN);
+            windowCodes[prnIndex].resize(4 * size_t(samplesPerCode));
+            for (int i = 0; i < 2 * samplesPerCode; ++i) {
+                windowCodes[prnIndex][2 * i] = caCodeReplica[codeOversampIdx[i % samplesPerCode]];
+                windowCodes[prnIndex][2 * i + 1] = windowCodes[prnIndex][2 * i];
+            }
+        }
+    }
 
-            // Remove carrier from signal (demodulation)
-            std::vector<double> I1(samplesPerCode), Q1(samplesPerCode), I2(samplesPerCode), Q2(samplesPerCode);
-            for (int i = 0; i < samplesPerCode; ++i) {
-                I1[i] = sinCarrReplica[i] * signal1[i];
-                Q1[i] = cosCarrReplica[i] * signal1[i];
-                I2[i] = sinCarrReplica[i] * signal2[i];
-                Q2[i] = cosCarrReplica[i] * signal2[i];
+    // The search is split in tiles of acqTileBins frequency bins x acqTilePrns PRNs. Every
+    // (PRN, bin) cell is written by exactly one tile, so the result does not depend on the
+    // thread count or the order tiles run in. Tiles are numbered PRN group first, so with
+    // acqTilePrns set the first PRNs complete (and are reported) before the last ones.
+    int tileBins = std::clamp(settings.acqTileBins, 1, nFrqBins);
+    int tilePrns = settings.acqTilePrns > 0 ? std::min(settings.acqTilePrns, numPrns) : numPrns;
+    int binTiles = (nFrqBins + tileBins - 1) / tileBins;
+    int prnTiles = (numPrns + tilePrns - 1) / tilePrns;
+
+    // A shared pool may hand a tile to any of its workers
+    int numWorkers = settings.acqThreads > 0 ? settings.acqThreads : std::max(1u, std::thread::hardware_concurrency());
+    numWorkers = pool ? pool->size() : std::min(numWorkers, binTiles * prnTiles);
+    std::vector<CorrelatorScratch<T>> scratch;
+    scratch.reserve(numWorkers);
+    for (int w = 0; w < numWorkers; ++w) {
+        scratch.emplace_back(samplesPerCode, samplesPerCodeChip, numBlocks, coherentMs);
+        scratch.back().windowCorrelation.resize(size_t(numBlocks) * maxWindowDelays);
+        scratch.back().windowPower1.resize(maxWindowDelays);
+        scratch.back().windowPower2.resize(maxWindowDelays);
+    }
+
+    std::vector<typename Fftw<T>::Buffer> fineSpectra;  // Coherent block spectra of each fine bin
+    if (circularShift) {
+        for (int fineBin = 0; fineBin < numFineBins; ++fineBin) {
+            const std::complex<T>* spectra = blockSpectra(fineBin, scratch[0]);
+            fineSpectra.push_back(Fftw<T>::alloc(size_t(numBlocks) * samplesPerCode));
+            std::copy(spectra, spectra + size_t(numBlocks) * samplesPerCode, asComplex<T>(fineSpectra.back().get()));
+        }
+    }
+
+    // Fine frequency stage: wipe the detected code phase and the bin frequency off the first
+    // acqFineMs code periods, integrate and dump dumpsPerCode times per code period, square the
+    // dumps to remove the navigation data bits and locate the residual (doubled) frequency with
+    // a zero-padded DFT
+    int dumpsPerCode = fineDumpsPerCode(settings);
+    typename Fftw<T>::Plan fineFftPlan = nullptr;
+    if (settings.acqFineFrequency) {
+        checkFineFrequency(settings);
+        fineFftPlan = Fftw<T>::plan(settings.acqFineFftSize, FFTW_FORWARD);
+        for (CorrelatorScratch<T>& buffers : scratch) {
+            buffers.fineRecord.resize(size_t(settings.acqFineMs) * samplesPerCode);
+            buffers.fineArr = Fftw<T>::alloc(settings.acqFineFftSize);
+            buffers.fineSpectrumArr = Fftw<T>::alloc(settings.acqFineFftSize);
+        }
+    }
+
+    auto refineFrequency = [&](int prnIndex, CorrelatorScratch<T>& buffers) {
+        METRICS_STAGE(FineFrequency);
+        METRICS_COUNT(FftsExecuted, 1);
+        int PRN = settings.satMask[prnIndex];
+        SearchPeakSummary peak = acqResults.searchSpace.peak(PRN);
+        int fftSize = settings.acqFineFftSize;
+        int fineMs = settings.acqFineMs;
+
+        const std::complex<T>* signals[1] = {signal};
+        std::complex<T>* record[1] = {buffers.fineRecord.data()};
+        carrierWipeOff(signals, record, 1, fineMs * samplesPerCode, frqBins[peak.bin] - carrierOffset,
+                       searchSamplingFreq);
+
+        // The code is periodic, so the replica aligned with the peak wipes every code period
+        const auto& caCodeReplica = caCodeTable.chips.at(PRN);
+        std::complex<T>* fine = asComplex<T>(buffers.fineArr.get());
+        std::fill(fine, fine + fftSize, std::complex<T>(0, 0));
+        for (int ms = 0; ms < fineMs; ++ms) {
+            const std::complex<T>* period = buffers.fineRecord.data() + size_t(ms) * samplesPerCode;
+            for (int dumpIndex = 0; dumpIndex < dumpsPerCode; ++dumpIndex) {
+                std::complex<T> dump = 0;
+                int end = (dumpIndex + 1) * samplesPerCode / dumpsPerCode;
+                for (int i = dumpIndex * samplesPerCode / dumpsPerCode; i < end; ++i) {
+                    int codeSample = (i + samplesPerCode - static_cast<int>(peak.delay)) % samplesPerCode;
+                    dump += period[i] * T(caCodeReplica[codeOversampIdx[codeSample]]);
+                }
+                fine[ms * dumpsPerCode + dumpIndex] = dump * dump;
             }
+        }
+        Fftw<T>::execute(fineFftPlan, buffers.fineArr.get(), buffers.fineSpectrumArr.get());
 
-            // Convert to frequency domain
-            fftw_complex* IQfreqDom1Arr = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * samplesPerCode);
-            fftw_complex* IQfreqDom2Arr = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * samplesPerCode);
-            fftw_plan IQplan1 = fftw_plan_dft_1d(samplesPerCode, (fftw_complex*)I1.data(),
-                                                 IQfreqDom1Arr, FFTW_FORWARD, FFTW_ESTIMATE);
-            fftw_plan IQplan2 = fftw_plan_dft_1d(samplesPerCode, (fftw_complex*)I2.data(),
-                                                 IQfreqDom2Arr, FFTW_FORWARD, FFTW_ESTIMATE);
-            fftw_execute(IQplan1);
-            fftw_execute(IQplan2);
-
-            // Frequency domain multiplication (correlation in time domain)
-            std::vector<std::complex<double>> convCodeIQ1(samplesPerCode), convCodeIQ2(samplesPerCode);
-            for (int i = 0; i < samplesPerCode; ++i) {
-                convCodeIQ1[i] = IQfreqDom1Arr[i] * caCodeReplicaFreqDom[i];
-                convCodeIQ2[i] = IQfreqDom2Arr[i] * caCodeReplicaFreqDom[i];
+        const std::complex<T>* spectrum = asComplex<T>(buffers.fineSpectrumArr.get());
+        int maxIndex = 0;
+        for (int k = 1; k < fftSize; ++k) {
+            if (std::norm(spectrum[k]) > std::norm(spectrum[maxIndex])) {
+                maxIndex = k;
             }
+        }
+        double dumpRate = dumpsPerCode * settings.codeFreqBasis / settings.codeLength;  // [Hz]
+        double doubledFrequency = (maxIndex <= fftSize / 2 ? maxIndex : maxIndex - fftSize) * dumpRate / fftSize;
 
-            // Inverse DFT and store correlation results
-            std::vector<double> acqRes1(samplesPerCode), acqRes2(samplesPerCode);
-            fftw_complex* acqRes1Arr = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * samplesPerCode);
-            fftw_complex* acqRes2Arr = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * samplesPerCode);
-            fftw_plan ifftPlan1 = fftw_plan_dft_1d(samplesPerCode, (fftw_complex*)convCodeIQ1.data(),
-                                                    acqRes1Arr, FFTW_BACKWARD, FFTW_ESTIMATE);
-            fftw_plan ifftPlan2 = fftw_plan_dft_1d(samplesPerCode, (fftw_complex*)convCodeIQ2.data(),
-                                                    acqRes2Arr, FFTW_BACKWARD, FFTW_ESTIMATE);
-            fftw_execute(ifftPlan1);
-            fftw_execute(ifftPlan2);
-
-            // Calculate magnitude squared
-            for (int i = 0; i < samplesPerCode; ++i) {
-                acqRes1[i] = std::norm(acqRes1Arr[i]);
-                acqRes2[i] = std::norm(acqRes2Arr[i]);
+        // The carrier replica is sin + j cos, i.e. it mixes the signal down by frqBins[bin]
+        acqResults.carrFreq[PRN] = frqBins[peak.bin] + doubledFrequency / 2;
+    };
+
+    // Correlate the coherent block spectra of a bin (rotated by shift DFT bins) with the code of a
+    // PRN over the whole code period. Returns the power of the candidate set with the highest peak
+    // and its summary.
+    auto correlateRow = [&](int prnIndex, const std::complex<T>* signalFreqDom, int shift,
+                            CorrelatorScratch<T>& buffers) -> std::pair<const T*, SearchRowSummary> {
+        std::complex<T>* convCodeIQ = asComplex<T>(buffers.convCodeIQArr.get());
+        std::complex<T>* acqRes = asComplex<T>(buffers.acqResArr.get());
+        std::vector<T>& acqRes1 = buffers.acqRes1;
+        std::vector<T>& acqRes2 = buffers.acqRes2;
+        const std::vector<std::complex<T>>& caCodeReplicaFreqDom = *codeBank[prnIndex];
+
+        // Frequency domain multiplication (correlation in time domain) and inverse DFT of every block
+        {
+            METRICS_STAGE(CodeMultiply);
+            for (int block = 0; block < numBlocks; ++block) {
+                multiplySpectra(signalFreqDom + size_t(block) * samplesPerCode, shift, caCodeReplicaFreqDom.data(),
+                                convCodeIQ + size_t(block) * samplesPerCode, samplesPerCode);
+            }
+        }
+        {
+            METRICS_STAGE(InverseFft);
+            METRICS_COUNT(FftsExecuted, numBlocks);
+            Fftw<T>::execute(ifftPlan, buffers.convCodeIQArr.get(), buffers.acqResArr.get());
+        }
+
+        // Non-coherent accumulation of the power of each candidate set
+        METRICS_STAGE(PeakSearch);
+        size_t peak1 = buffers.detector1.process(acqRes, numSums, samplesPerCode, acqRes1.data());
+        size_t peak2 = buffers.detector2.process(acqRes + size_t(numSums) * samplesPerCode, numSums, samplesPerCode,
+                                                 acqRes2.data());
+        if (acqRes1[peak1] > acqRes2[peak2]) {
+            return {acqRes1.data(), buffers.detector1.summarize(acqRes1.data())};
+        }
+        return {acqRes2.data(), buffers.detector2.summarize(acqRes2.data())};
+    };
+
+    // Tiles run on the shared pool, on a pool of the search's own or, with one worker, inline
+    std::unique_ptr<WorkStealingPool> searchPool;
+    if (!pool && numWorkers > 1) {
+        searchPool = std::make_unique<WorkStealingPool>(numWorkers);
+    }
+    auto runTiles = [&](size_t numTiles, const std::function<void(size_t, int)>& task) {
+        WorkStealingPool* tilePool = pool ? pool : searchPool.get();
+        if (tilePool) {
+            tilePool->run(numTiles, task);
+            return;
+        }
+        for (size_t tile = 0; tile < numTiles; ++tile) {
+            task(tile, 0);
+        }
+    };
+
+    // Noise statistics of the time-domain windows: the whole code period of their PRN at the bin
+    // nearest to the hint, searched before the windows
+    std::vector<SearchRowSummary> windowReferences(numPrns);
+    std::vector<int> referencePrns;
+    for (int prnIndex = 0; prnIndex < numPrns; ++prnIndex) {
+        if (windows[prnIndex].timeDomain && windows[prnIndex].firstBin < windows[prnIndex].lastBin) {
+            referencePrns.push_back(prnIndex);
+        }
+    }
+    runTiles(referencePrns.size(), [&](size_t index, int worker) {
+        int prnIndex = referencePrns[index];
+        int bin = windows[prnIndex].referenceBin;
+        METRICS_COUNT_SEARCH(settings.satMask[prnIndex], bin, size_t(codePeriods) * samplesPerCode);
+        windowReferences[prnIndex] = correlateRow(prnIndex, blockSpectra(bin, scratch[worker]), 0, scratch[worker]).second;
+    });
+
+    // A PRN is decided by the worker that completes its last frequency bin
+    std::vector<std::atomic<int>> binsDone(numPrns);
+    for (std::atomic<int>& done : binsDone) {
+        done = 0;
+    }
+
+    auto searchTile = [&](size_t tile, int worker) {
+        CorrelatorScratch<T>& buffers = scratch[worker];
+
+        int firstBin = (tile % binTiles) * tileBins;
+        int lastBin = std::min(firstBin + tileBins, nFrqBins);
+        int firstPrn = (tile / binTiles) * tilePrns;
+        int lastPrn = std::min(firstPrn + tilePrns, numPrns);
+
+        // Correlate signals for the frequency bins of the tile
+        for (int frqBinIndex = firstBin; frqBinIndex < lastBin; ++frqBinIndex) {
+            bool needSpectra = false, needIQ = false;
+            for (int prnIndex = firstPrn; prnIndex < lastPrn; ++prnIndex) {
+                if (windows[prnIndex].contains(frqBinIndex)) {
+                    (windows[prnIndex].timeDomain ? needIQ : needSpectra) = true;
+                }
+            }
+
+            const std::complex<T>* signalFreqDom = nullptr;
+            int shift = 0;
+            bool packed = false;  // IQArr of this bin is in buffers.packedIQ
+
+            if (circularShift) {
+                int fineBin = frqBinIndex % numFineBins;
+                signalFreqDom = asComplex<T>(fineSpectra[fineBin].get());
+                shift = (frqBinIndex / numFineBins) % samplesPerCode;
+            } else if (needSpectra) {
+                // Convert to frequency domain, once for all PRNs of the tile
+                signalFreqDom = blockSpectra(frqBinIndex, buffers);
+            } else if (needIQ) {
+                wipeOffBlocks(frqBinIndex, buffers);
+            }
+
+            for (int prnIndex = firstPrn; prnIndex < lastPrn; ++prnIndex) {
+                const PrnWindow& window = windows[prnIndex];
+                if (!window.contains(frqBinIndex)) {
+                    continue;
+                }
+                int PRN = settings.satMask[prnIndex];
+                METRICS_COUNT_SEARCH(PRN, frqBinIndex, size_t(codePeriods) * samplesPerCode);
+
+                if (window.timeDomain) {
+                    std::complex<T>* correlation = buffers.windowCorrelation.data();
+                    {
+                        METRICS_STAGE(TimeDomainCorrelation);
+                        if (packedBits) {
+                            if (!packed) {
+                                buffers.packedIQ.pack(asComplex<T>(buffers.IQArr.get()), codePeriods, samplesPerCode,
+                                                      packedBits);
+                                packed = true;
+                            }
+                            correlatePacked(buffers.packedIQ, coherentMs, packedCodes[prnIndex], window.firstDelay,
+                                            window.numDelays, correlation);
+                        } else {
+                            correlateDelays(asComplex<T>(buffers.IQArr.get()), numBlocks, coherentMs, samplesPerCode,
+                                            windowCodes[prnIndex].data(), window.firstDelay, window.numDelays,
+                                            correlation);
+                        }
+                    }
+                    METRICS_STAGE(PeakSearch);
+                    T* power1 = buffers.windowPower1.data();
+                    T* power2 = buffers.windowPower2.data();
+                    accumulateWindow(correlation, numSums, window.numDelays, power1);
+                    accumulateWindow(correlation + size_t(numSums) * window.numDelays, numSums, window.numDelays, power2);
+
+                    int numDelays = window.numDelays;
+                    int firstDelay = window.firstDelay;
+
+                    // Packed powers are in quantization levels: the packed window only locates the
+                    // peak, whose power is measured again with the floating-point correlator
+                    if (packedBits) {
+                        const T* best = *std::max_element(power1, power1 + numDelays)
+                                > *std::max_element(power2, power2 + numDelays) ? power1 : power2;
+                        int peak = static_cast<int>(std::max_element(best, best + numDelays) - best);
+                        numDelays = std::min(packedPeakDelays, window.numDelays);
+                        firstDelay = (firstDelay + peak - numDelays / 2 + samplesPerCode) % samplesPerCode;
+                        correlateDelays(asComplex<T>(buffers.IQArr.get()), numBlocks, coherentMs, samplesPerCode,
+                                        windowCodes[prnIndex].data(), firstDelay, numDelays, correlation);
+                        accumulateWindow(correlation, numSums, numDelays, power1);
+                        accumulateWindow(correlation + size_t(numSums) * numDelays, numSums, numDelays, power2);
+                    }
+                    const T* best = *std::max_element(power1, power1 + numDelays)
+                            > *std::max_element(power2, power2 + numDelays) ? power1 : power2;
+                    acqResults.searchSpace.store(PRN, frqBinIndex, static_cast<const T*>(nullptr),
+                                                 summarizeWindow(best, numDelays, firstDelay, samplesPerCode,
+                                                                 samplesPerCodeChip, windowReferences[prnIndex]));
+                    continue;
+                }
+
+                // Store the set with the highest peak straight into its row of the search space
+                auto [row, summary] = correlateRow(prnIndex, signalFreqDom, shift, buffers);
+                acqResults.searchSpace.store(PRN, frqBinIndex, row, summary);
+            }
+        }
+
+        // Decide the PRNs whose last frequency bin was in this tile
+        for (int prnIndex = firstPrn; prnIndex < lastPrn; ++prnIndex) {
+            if (binsDone[prnIndex].fetch_add(lastBin - firstBin) + (lastBin - firstBin) == nFrqBins) {
+                int PRN = settings.satMask[prnIndex];
+                acqResults.detect(PRN, settings, frqBins);
+                if (settings.acqFineFrequency && acqResults.acquired[PRN]) {
+                    refineFrequency(prnIndex, buffers);
+                }
+                if (onPrnDone) {
+                    onPrnDone(acqResults, PRN);
+                }
             }
+        }
+    };
+
+    runTiles(binTiles * prnTiles, searchTile);
+
+    return acqResults;
+}
+
+// Run the search again in the other precision and compare the detections: the decision of every
+// PRN, the peak location of every PRN acquired by either search and the peak metric (relative
+// difference; a metric of 0 only matches 0, and a metric that is not a number matches nothing)
+template <typename Other, typename Input>
+static void validatePrecision(const Settings& settings, const Input& inputSignal, const AcqResults& acqResults,
+                              const std::vector<AcquisitionHint>* hints, WorkStealingPool* pool) {
+    AcqResults reference = searchGpsL1CImpl<Other>(settings, inputSignal, AcquisitionCallback(), hints, pool);
+    std::string referencePrecision = std::is_same_v<Other, float> ? "float" : "double";
+
+    int mismatches = 0;
+    for (int PRN : settings.satMask) {
+        SearchPeakSummary peak = acqResults.searchSpace.peak(PRN);
+        SearchPeakSummary referencePeak = reference.searchSpace.peak(PRN);
+        double metric = acqResults.peakMetric[PRN];
+        double referenceMetric = reference.peakMetric[PRN];
+        double metricError = referenceMetric != 0.0 ? std::abs(metric - referenceMetric) / referenceMetric
+                           : metric == 0.0          ? 0.0
+                                                    : std::numeric_limits<double>::infinity();
+
+        bool mismatch = acqResults.acquired[PRN] != reference.acquired[PRN] ||
+                        !(metricError <= settings.acqPrecisionTolerance);
+        if (acqResults.acquired[PRN] || reference.acquired[PRN]) {
+            mismatch |= peak.bin != referencePeak.bin || peak.delay != referencePeak.delay;
+        }
+        if (mismatch) {
+            ++mismatches;
+            std::cerr << "Precision mismatch on PRN " << PRN << ": bin " << peak.bin << " delay " << peak.delay
+                      << " metric " << metric << " (" << referencePrecision << ": bin " << referencePeak.bin
+                      << " delay " << referencePeak.delay << " metric " << referenceMetric << ")\n";
+        }
+    }
+
+    std::cout << "Precision validation against " << referencePrecision << ": "
+              << (mismatches == 0 ? "all detections match" : std::to_string(mismatches) + " PRN differ") << "\n";
+}
 
-            // Store results for the frequency bin
-            if (max(acqRes1) > max(acqRes2)) {
-                results[frqBinIndex] = acqRes1;
+// Search in settings.acqPrecision, optionally validated against the other precision
+template <typename Input>
+static AcqResults searchInPrecision(const Settings& settings, const Input& inputSignal,
+                                    const AcquisitionCallback& onPrnDone,
+                                    const std::vector<AcquisitionHint>* hints = nullptr,
+                                    WorkStealingPool* pool = nullptr) {
+    bool singlePrecision = settings.acqPrecision == "float";
+    if (!singlePrecision && settings.acqPrecision != "double") {
+        throw std::invalid_argument("Unknown acquisition precision: " + settings.acqPrecision);
+    }
+
+    if (settings.acqPrintResults) {
+        std::cout << "Acquiring GPS L1C ...\n(";
+    }
+    AcqResults acqResults = singlePrecision ? searchGpsL1CImpl<float>(settings, inputSignal, onPrnDone, hints, pool)
+                                            : searchGpsL1CImpl<double>(settings, inputSignal, onPrnDone, hints, pool);
+
+    // Acquired PRNs, ". " for the ones that were not
+    if (settings.acqPrintResults) {
+        for (int PRN : settings.satMask) {
+            if (acqResults.acquired[PRN]) {
+                std::cout << PRN << " ";
             } else {
-                results[frqBinIndex] = acqRes2;
+                std::cout << ". ";
             }
         }
+        std::cout << ")\n";
+    }
+
+    if (settings.acqValidatePrecision) {
+        if (singlePrecision) {
+            validatePrecision<double>(settings, inputSignal, acqResults, hints, pool);
+        } else {
+            validatePrecision<float>(settings, inputSignal, acqResults, hints, pool);
+        }
+    }
+    return acqResults;
+}
+
+AcqResults searchGpsL1C(const Settings& settings, const std::vector<std::complex<double>>& inputSignal,
+                        const AcquisitionCallback& onPrnDone, WorkStealingPool* pool) {
+    return searchInPrecision(settings, inputSignal, onPrnDone, nullptr, pool);
+}
+
+AcqResults searchGpsL1C(const Settings& settings, const std::vector<std::complex<float>>& inputSignal,
+                        const AcquisitionCallback& onPrnDone, WorkStealingPool* pool) {
+    return searchInPrecision(settings, inputSignal, onPrnDone, nullptr, pool);
+}
+
+AcqResults searchGpsL1C(const Settings& settings, const SearchSignal<double>& searchSignal,
+                        const AcquisitionCallback& onPrnDone, WorkStealingPool* pool) {
+    return searchInPrecision(settings, searchSignal, onPrnDone, nullptr, pool);
+}
 
-        // Further processing for peak finding, SNR calculation, and signal acquisition continues...
+AcqResults searchGpsL1C(const Settings& settings, const SearchSignal<float>& searchSignal,
+                        const AcquisitionCallback& onPrnDone, WorkStealingPool* pool) {
+    return searchInPrecision(settings, searchSignal, onPrnDone, nullptr, pool);
+}
+
+// Warm start: search the hinted PRNs only. The search space keeps no surface (rows outside the
+// windows are never searched) and the circular-shift search is off (it transforms a fixed set of
+// bins whatever the windows are).
+template <typename Input>
+static AcqResults reacquire(const Settings& settings, const Input& inputSignal,
+                            const std::vector<AcquisitionHint>& hints, const AcquisitionCallback& onPrnDone) {
+    if (hints.empty()) {
+        throw std::invalid_argument("No PRN to reacquire");
+    }
+    if (settings.acqWarmCodeWindowChips != 0 && settings.acqWarmCodeWindowChips < 2) {
+        throw std::invalid_argument("acqWarmCodeWindowChips must be 0 (whole code) or at least 2 chips");
+    }
+    if (settings.acqPackedBits < 0 || settings.acqPackedBits > 2) {
+        throw std::invalid_argument("acqPackedBits must be 0 (off), 1 or 2");
+    }
 
+    // The first hint of a PRN wins
+    Settings warmSettings = settings;
+    warmSettings.satMask.clear();
+    std::vector<AcquisitionHint> prnHints;
+    for (const AcquisitionHint& hint : hints) {
+        if (hint.PRN < 1 || hint.PRN > caCodeMaxPRN) {
+            throw std::invalid_argument("Invalid hint PRN " + std::to_string(hint.PRN));
+        }
+        if (std::find(warmSettings.satMask.begin(), warmSettings.satMask.end(), hint.PRN) == warmSettings.satMask.end()) {
+            warmSettings.satMask.push_back(hint.PRN);
+            prnHints.push_back(hint);
+        }
     }
+    warmSettings.acqSearchSpaceStorage = "summary";
+    warmSettings.acqCircularShiftSearch = false;
+    return searchInPrecision(warmSettings, inputSignal, onPrnDone, &prnHints);
+}
 
-    std::cout << ")\n";
+AcqResults reacquireGpsL1C(const Settings& settings, const std::vector<std::complex<double>>& inputSignal,
+                           const std::vector<AcquisitionHint>& hints, const AcquisitionCallback& onPrnDone) {
+    return reacquire(settings, inputSignal, hints, onPrnDone);
+}
 
-    // Plot results
-    acqResults.plot(settings, samplesPerCode, nFrqBins);
+AcqResults reacquireGpsL1C(const Settings& settings, const std::vector<std::complex<float>>& inputSignal,
+                           const std::vector<AcquisitionHint>& hints, const AcquisitionCallback& onPrnDone) {
+    return reacquire(settings, inputSignal, hints, onPrnDone);
+}
+
+AcqResults reacquireGpsL1C(const Settings& settings, const SearchSignal<double>& searchSignal,
+                           const std::vector<AcquisitionHint>& hints, const AcquisitionCallback& onPrnDone) {
+    return reacquire(settings, searchSignal, hints, onPrnDone);
+}
+
+AcqResults reacquireGpsL1C(const Settings& settings, const SearchSignal<float>& searchSignal,
+                           const std::vector<AcquisitionHint>& hints, const AcquisitionCallback& onPrnDone) {
+    return reacquire(settings, searchSignal, hints, onPrnDone);
+}
+
+// Search and dump the results for plotting
+template <typename Input>
+static AcqResults searchAndDump(const Settings& settings, const Input& inputSignal) {
+    AcqResults acqResults = searchGpsL1C(settings, inputSignal);
+
+    if (settings.acqDumpResults) {
+        acqResults.dump(settings, acquisitionOutputDir(settings));
+    }
 
     return acqResults;
 }
 
+AcqResults acquisitionGpsL1C(const Settings& settings, const std::vector<std::complex<double>>& inputSignal) {
+    return searchAndDump(settings, inputSignal);
+}
+
+AcqResults acquisitionGpsL1C(const Settings& settings, const std::vector<std::complex<float>>& inputSignal) {
+    return searchAndDump(settings, inputSignal);
+}
+
+AcqResults acquisitionGpsL1C(const Settings& settings, const SearchSignal<double>& searchSignal) {
+    return searchAndDump(settings, searchSignal);
+}
+
+AcqResults acquisitionGpsL1C(const Settings& settings, const SearchSignal<float>& searchSignal) {
+    return searchAndDump(settings, searchSignal);
+}
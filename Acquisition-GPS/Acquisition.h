@@ -3,13 +3,113 @@
 
 #include <vector>
 #include <complex>
+#include <string>
+#include <functional>
 #include "SettingsGps.h"
+#include "SearchSpace.h"
+#include "AcquisitionHints.h"
 
-struct AcqResults {
-    double carrierFrequency;  // Frecuencia portadora estimada
-    double codePhase;         // Fase de código estimada
+class WorkStealingPool;
+
+class AcqResults {
+public:
+    SearchSpace searchSpace;         // Search space [PRN][frequency bin][code delay]
+    std::vector<double> carrFreq;    // Carrier frequencies of detected signals
+    std::vector<double> codeDelay;  // Code delays of detected signals
+    std::vector<double> peakMetric; // Correlation peak ratios
+    std::vector<double> SNR;        // Signal-to-Noise ratio (C/N0 estimate) [dB-Hz], 0 if not acquired
+    std::vector<int> acquired;      // 1 if the peak metric is above settings.acqTh
+    double searchSamplingFreq;      // Sampling rate of the searchSpace code delay axis [Hz]
+
+    // Initialize the acquisition results for a search at searchSamplingFreq
+    void initialize(const Settings& settings, double searchSamplingFreq);
+
+    // Fill peakMetric, SNR and the acquisition decision of PRN from its search space summaries
+    void detect(int PRN, const Settings& settings, const std::vector<double>& frqBins);
+
+    // Search space code delay expressed in samples of the input signal
+    double delayInInputSamples(double delay, const Settings& settings) const {
+        return delay * settings.samplingFreq / searchSamplingFreq;
+    }
+
+    // Write the peak metrics, the C/N0 and (if kept) the search space of every PRN, downsampled
+    // to settings.acqDumpBins x settings.acqDumpDelays, as .npy files in dir for PlotAcquisition
+    void dump(const Settings& settings, const std::string& dir) const;
 };
 
+// Directory results are dumped to: SW-RCVR-C++/ next to the input file
+std::string acquisitionOutputDir(const Settings& settings);
+
+// Signal as the search consumes it: the input after the optional resampling front-end, in the
+// search precision. A view; the samples belong to the caller (e.g. a SampleCache mapping).
+template <typename T>
+struct SearchSignal {
+    const std::complex<T>* samples = nullptr;
+    size_t numSamples = 0;       // At least searchSignalSampleCount(settings)
+    double samplingFreq = 0.0;   // searchSamplingFrequency(settings) [Hz]
+    double carrierOffset = 0.0;  // Carrier frequency the front-end removed: searchCarrierOffset(settings) [Hz]
+};
+
+// Smallest power of two not below n (the default resampled code period is nextPowerOf2(4 * codeLength))
+int nextPowerOf2(int n);
+
+// Sampling frequency of the search signal (after the optional resampling front-end) [Hz]
+double searchSamplingFrequency(const Settings& settings);
+
+// Carrier frequency the front-end removes: IF when resampling to baseband, else 0 [Hz]
+double searchCarrierOffset(const Settings& settings);
+
+// Number of search signal samples the search reads
+size_t searchSignalSampleCount(const Settings& settings);
+
+// Number of input samples the search reads from the start of the signal:
+// 2 candidate sets x acqNonCoherentSums x acqCoherentMs code periods, or acqFineMs code periods
+// if the fine frequency stage needs more
+size_t acquisitionSampleCount(const Settings& settings);
+
+// Absolute carrier frequency of every search bin [Hz], acqFreqStepHz / acqCoherentMs apart
+std::vector<double> acquisitionFrequencyBins(const Settings& settings);
+
+// Called with the results and a PRN as soon as all frequency bins of the PRN are searched and
+// its detection is decided; runs on the worker thread that searched the last bin
+using AcquisitionCallback = std::function<void(const AcqResults& acqResults, int PRN)>;
+
+// Search every PRN in settings.satMask over the Doppler/code-phase grid, in settings.acqPrecision
+// (the input is converted if needed). With settings.acqValidatePrecision the search is repeated
+// in the other precision and differing detections are reported. The search runs on pool when
+// given (successive searches then reuse its threads), else on settings.acqThreads threads of its
+// own. The acquired PRNs are printed unless settings.acqPrintResults is off.
+AcqResults searchGpsL1C(const Settings& settings, const std::vector<std::complex<double>>& inputSignal,
+                        const AcquisitionCallback& onPrnDone = AcquisitionCallback(), WorkStealingPool* pool = nullptr);
+AcqResults searchGpsL1C(const Settings& settings, const std::vector<std::complex<float>>& inputSignal,
+                        const AcquisitionCallback& onPrnDone = AcquisitionCallback(), WorkStealingPool* pool = nullptr);
+AcqResults searchGpsL1C(const Settings& settings, const SearchSignal<double>& searchSignal,
+                        const AcquisitionCallback& onPrnDone = AcquisitionCallback(), WorkStealingPool* pool = nullptr);
+AcqResults searchGpsL1C(const Settings& settings, const SearchSignal<float>& searchSignal,
+                        const AcquisitionCallback& onPrnDone = AcquisitionCallback(), WorkStealingPool* pool = nullptr);
+
+// Warm start: search only the PRNs of hints, within settings.acqWarmFreqWindowHz of their carrier
+// frequency and, when their code delay is known, within settings.acqWarmCodeWindowChips of it
+// (after settings.acqWarmSampleOffset input samples). Only summaries of the search are kept.
+// The second peak and noise floor of a code window come from the whole code period of its PRN
+// at the bin nearest to the hint, so windows detect at the false alarm rate of a full search.
+AcqResults reacquireGpsL1C(const Settings& settings, const std::vector<std::complex<double>>& inputSignal,
+                           const std::vector<AcquisitionHint>& hints,
+                           const AcquisitionCallback& onPrnDone = AcquisitionCallback());
+AcqResults reacquireGpsL1C(const Settings& settings, const std::vector<std::complex<float>>& inputSignal,
+                           const std::vector<AcquisitionHint>& hints,
+                           const AcquisitionCallback& onPrnDone = AcquisitionCallback());
+AcqResults reacquireGpsL1C(const Settings& settings, const SearchSignal<double>& searchSignal,
+                           const std::vector<AcquisitionHint>& hints,
+                           const AcquisitionCallback& onPrnDone = AcquisitionCallback());
+AcqResults reacquireGpsL1C(const Settings& settings, const SearchSignal<float>& searchSignal,
+                           const std::vector<AcquisitionHint>& hints,
+                           const AcquisitionCallback& onPrnDone = AcquisitionCallback());
+
+// Search and, with settings.acqDumpResults, dump the results for plotting
 AcqResults acquisitionGpsL1C(const Settings& settings, const std::vector<std::complex<double>>& inputSignal);
+AcqResults acquisitionGpsL1C(const Settings& settings, const std::vector<std::complex<float>>& inputSignal);
+AcqResults acquisitionGpsL1C(const Settings& settings, const SearchSignal<double>& searchSignal);
+AcqResults acquisitionGpsL1C(const Settings& settings, const SearchSignal<float>& searchSignal);
 
 #endif // ACQUISITION_GPS_H
@@ -0,0 +1,155 @@
+/*
+########################################################################
+# AcquisitionHints.cpp:
+# Persisted acquisition results and visibility lists for warm starts
+#
+#  Project:        sw-rcvr-c++
+#  File:           AcquisitionHints.cpp
+#
+########################################################################
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "AcquisitionHints.h"
+#include "Acquisition.h"
+#include "Goldencodes.h"
+#include "Metrics.h"
+
+constexpr char resultsMagic[8] = {'G', 'P', 'S', 'A', 'C', 'Q', '\0', '\0'};
+constexpr uint32_t resultsVersion = 1;
+
+// All fields are written one by one in native byte order, so the layout has no padding
+template <typename V>
+static void writeValue(std::ofstream& out, V value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename V>
+static V readValue(std::ifstream& in, const std::string& path) {
+    V value;
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(value))) {
+        throw std::runtime_error("Truncated acquisition results file " + path);
+    }
+    return value;
+}
+
+void saveAcquisitionResults(const std::string& path, const Settings& settings, const AcqResults& acqResults) {
+    METRICS_STAGE(ResultsOutput);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot write acquisition results to " + path);
+    }
+
+    std::vector<int> prns;
+    for (int PRN : settings.satMask) {
+        if (PRN < static_cast<int>(acqResults.acquired.size())) {
+            prns.push_back(PRN);
+        }
+    }
+
+    out.write(resultsMagic, sizeof(resultsMagic));
+    writeValue<uint32_t>(out, resultsVersion);
+    writeValue<uint32_t>(out, static_cast<uint32_t>(prns.size()));
+    writeValue<double>(out, settings.samplingFreq);
+    writeValue<double>(out, settings.IF);
+
+    // One record per PRN: PRN, acquired flag, carrier frequency, code delay, metric and C/N0
+    for (int PRN : prns) {
+        writeValue<int32_t>(out, PRN);
+        writeValue<int32_t>(out, acqResults.acquired[PRN]);
+        writeValue<double>(out, acqResults.carrFreq[PRN]);
+        writeValue<double>(out, acqResults.codeDelay[PRN]);
+        writeValue<double>(out, acqResults.peakMetric[PRN]);
+        writeValue<double>(out, acqResults.SNR[PRN]);
+    }
+    if (!out) {
+        throw std::runtime_error("Cannot write acquisition results to " + path);
+    }
+}
+
+std::vector<AcquisitionHint> loadAcquisitionResults(const std::string& path, const Settings& settings) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open acquisition results file " + path);
+    }
+
+    char magic[sizeof(resultsMagic)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, resultsMagic, sizeof(magic)) != 0) {
+        throw std::runtime_error(path + " is not an acquisition results file");
+    }
+    uint32_t version = readValue<uint32_t>(in, path);
+    if (version != resultsVersion) {
+        throw std::runtime_error("Unsupported acquisition results version " + std::to_string(version) + " in " + path);
+    }
+    uint32_t numRecords = readValue<uint32_t>(in, path);
+    double samplingFreq = readValue<double>(in, path);
+    double IF = readValue<double>(in, path);
+
+    std::vector<AcquisitionHint> hints;
+    for (uint32_t i = 0; i < numRecords; ++i) {
+        int32_t PRN = readValue<int32_t>(in, path);
+        int32_t acquired = readValue<int32_t>(in, path);
+        double carrFreq = readValue<double>(in, path);
+        double codeDelay = readValue<double>(in, path);
+        readValue<double>(in, path);  // Peak metric
+        readValue<double>(in, path);  // C/N0
+        if (PRN < 1 || PRN > caCodeMaxPRN) {
+            throw std::runtime_error(path + ": record " + std::to_string(i + 1) + ": invalid PRN " +
+                                     std::to_string(PRN));
+        }
+        if (acquired) {
+            AcquisitionHint hint;
+            hint.PRN = PRN;
+            hint.carrFreq = carrFreq - IF + settings.IF;
+            hint.codeDelay = codeDelay * settings.samplingFreq / samplingFreq;
+            hints.push_back(hint);
+        }
+    }
+    return hints;
+}
+
+std::vector<AcquisitionHint> loadVisibilityList(const std::string& path, const Settings& settings) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot open visibility list " + path);
+    }
+
+    std::vector<AcquisitionHint> hints;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first) || first[0] == '#') {
+            continue;
+        }
+
+        AcquisitionHint hint;
+        double doppler;
+        size_t parsed = 0;
+        try {
+            hint.PRN = std::stoi(first, &parsed);
+        } catch (const std::exception&) {
+            parsed = 0;
+        }
+        if (parsed != first.size() || hint.PRN < 1 || hint.PRN > caCodeMaxPRN) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": invalid PRN " + first);
+        }
+        if (!(fields >> doppler)) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": missing Doppler");
+        }
+        hint.carrFreq = settings.IF + doppler;
+
+        double codePhase;
+        if (fields >> codePhase) {
+            hint.codeDelay = codePhase * settings.samplingFreq / settings.codeFreqBasis;
+        }
+        hints.push_back(hint);
+    }
+    return hints;
+}
@@ -0,0 +1,32 @@
+#ifndef ACQUISITION_HINTS_H
+#define ACQUISITION_HINTS_H
+
+#include <string>
+#include <vector>
+#include "SettingsGps.h"
+
+class AcqResults;
+
+// Expected signal of one satellite, used to narrow a warm-start search
+struct AcquisitionHint {
+    int PRN = 0;
+    double carrFreq = 0.0;    // Absolute carrier frequency [Hz] (IF + Doppler)
+    double codeDelay = -1.0;  // Code delay [input samples], negative if unknown
+};
+
+// Write the detections of the PRNs in settings.satMask covered by acqResults (a warm start only
+// covers its hints) to a compact binary file: a "GPSACQ" header (format version, sampling
+// frequency, IF) followed by one fixed-size record per PRN
+void saveAcquisitionResults(const std::string& path, const Settings& settings, const AcqResults& acqResults);
+
+// Hints of the PRNs acquired in a file written by saveAcquisitionResults. Frequencies keep their
+// Doppler and delays are rescaled if settings.IF or settings.samplingFreq changed. Throws
+// runtime_error on a record whose PRN has no C/A code (1..caCodeMaxPRN).
+std::vector<AcquisitionHint> loadAcquisitionResults(const std::string& path, const Settings& settings);
+
+// Hints from a text visibility list, one satellite per line: "PRN doppler_Hz [codePhase_chips]".
+// Empty lines and lines starting with '#' are skipped. Throws runtime_error with the line number
+// on a PRN outside 1..caCodeMaxPRN or a missing Doppler.
+std::vector<AcquisitionHint> loadVisibilityList(const std::string& path, const Settings& settings);
+
+#endif // ACQUISITION_HINTS_H
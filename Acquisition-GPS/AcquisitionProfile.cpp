@@ -0,0 +1,199 @@
+/*
+########################################################################
+# AcquisitionProfile.cpp:
+# Per-machine acquisition engine profiles written by AutotuneAcquisition
+#
+#  Project:        sw-rcvr-c++
+#  File:           AcquisitionProfile.cpp
+#
+########################################################################
+*/
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+#include "AcquisitionProfile.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char requirePrefix[] = "require ";
+
+// Lines of one host section, without the header
+struct ProfileSection {
+    std::string host;
+    std::vector<std::string> lines;
+};
+
+// Round-trip text of a number, so conditions compare exactly
+std::string numberText(double value) {
+    std::ostringstream text;
+    text.precision(17);
+    text << value;
+    return text.str();
+}
+
+std::string boolText(bool value) {
+    return value ? "true" : "false";
+}
+
+// PRN list as setSetting() reads it
+std::string satMaskText(const std::vector<int>& satMask) {
+    std::string text;
+    for (int PRN : satMask) {
+        text += (text.empty() ? "" : ",") + std::to_string(PRN);
+    }
+    return text;
+}
+
+std::vector<ProfileSection> readSections(const std::string& path) {
+    std::vector<ProfileSection> sections;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        size_t last = line.find_last_not_of(" \t\r");
+        line = line.substr(first, last - first + 1);
+        if (line.front() == '[' && line.back() == ']') {
+            sections.push_back({line.substr(1, line.size() - 2), {}});
+        } else if (sections.empty()) {
+            throw std::invalid_argument(path + ": setting outside a host section: " + line);
+        } else {
+            sections.back().lines.push_back(line);
+        }
+    }
+    return sections;
+}
+
+// Split "name=value"
+std::pair<std::string, std::string> splitEntry(const std::string& path, const std::string& line) {
+    size_t equals = line.find('=');
+    if (equals == std::string::npos || equals == 0) {
+        throw std::invalid_argument(path + ": expected name=value, got " + line);
+    }
+    return {line.substr(0, equals), line.substr(equals + 1)};
+}
+
+}
+
+ProfileEntries tunedAcquisitionSettings(const Settings& settings) {
+    return {{"acqResample", boolText(settings.acqResample)},
+            {"acqResampledSamplesPerCode", std::to_string(settings.acqResampledSamplesPerCode)},
+            {"acqPrecision", settings.acqPrecision},
+            {"fftPlanningEffort", settings.fftPlanningEffort},
+            {"acqThreads", std::to_string(settings.acqThreads)},
+            {"acqTileBins", std::to_string(settings.acqTileBins)},
+            {"acqTilePrns", std::to_string(settings.acqTilePrns)}};
+}
+
+ProfileEntries acquisitionProfileConditions(const Settings& settings) {
+    return {{"samplingFreq", numberText(settings.samplingFreq)},
+            {"IF", numberText(settings.IF)},
+            {"codeFreqBasis", numberText(settings.codeFreqBasis)},
+            {"codeLength", std::to_string(settings.codeLength)},
+            {"acqFreqRangekHz", std::to_string(settings.acqFreqRangekHz)},
+            {"acqFreqStepHz", numberText(settings.acqFreqStepHz)},
+            {"acqCoherentMs", std::to_string(settings.acqCoherentMs)},
+            {"acqNonCoherentSums", std::to_string(settings.acqNonCoherentSums)},
+            {"acqSearchSpaceStorage", settings.acqSearchSpaceStorage},
+            {"acqCircularShiftSearch", boolText(settings.acqCircularShiftSearch)},
+            {"acqFineFrequency", boolText(settings.acqFineFrequency)},
+            {"acqTh", numberText(settings.acqTh)},
+            {"satMask", satMaskText(settings.satMask)}};
+}
+
+std::string profileHostName() {
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) != 0 || name[0] == '\0') {
+        return "localhost";
+    }
+    return name;
+}
+
+bool loadAcquisitionProfile(const std::string& path, Settings& settings) {
+    if (!fs::exists(path)) {
+        return false;
+    }
+    std::string host = profileHostName();
+    for (const ProfileSection& section : readSections(path)) {
+        if (section.host != host) {
+            continue;
+        }
+
+        // Check every condition before applying anything
+        ProfileEntries conditions = acquisitionProfileConditions(settings);
+        ProfileEntries tuned;
+        for (const std::string& line : section.lines) {
+            if (line.compare(0, sizeof(requirePrefix) - 1, requirePrefix) != 0) {
+                tuned.push_back(splitEntry(path, line));
+                continue;
+            }
+            auto [name, value] = splitEntry(path, line.substr(sizeof(requirePrefix) - 1));
+            for (const auto& [currentName, currentValue] : conditions) {
+                if (currentName == name && currentValue != value) {
+                    std::cerr << "Warning: acquisition profile " << path << " was tuned for " << name << " = "
+                              << value << ", not " << currentValue << "; not applied (run AutotuneAcquisition)"
+                              << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        Settings profiled = settings;
+        for (const auto& [name, value] : tuned) {
+            try {
+                setSetting(profiled, name, value);
+            } catch (const std::invalid_argument& e) {
+                throw std::invalid_argument(path + " [" + host + "]: " + e.what());
+            }
+        }
+        settings = profiled;
+        return true;
+    }
+    return false;
+}
+
+void saveAcquisitionProfile(const std::string& path, const Settings& settings) {
+    std::string host = profileHostName();
+    std::vector<ProfileSection> sections = fs::exists(path) ? readSections(path) : std::vector<ProfileSection>();
+
+    // Write a temporary file and rename it, so other machines never read a partial profile
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Cannot write acquisition profile " + temporary);
+        }
+        out << "# Acquisition engine profiles written by AutotuneAcquisition, one section per host\n";
+        for (const ProfileSection& section : sections) {
+            if (section.host == host) {
+                continue;
+            }
+            out << "\n[" << section.host << "]\n";
+            for (const std::string& line : section.lines) {
+                out << line << "\n";
+            }
+        }
+        out << "\n[" << host << "]\n";
+        for (const auto& [name, value] : acquisitionProfileConditions(settings)) {
+            out << requirePrefix << name << "=" << value << "\n";
+        }
+        for (const auto& [name, value] : tunedAcquisitionSettings(settings)) {
+            out << name << "=" << value << "\n";
+        }
+        if (!out) {
+            throw std::runtime_error("Cannot write acquisition profile " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot replace acquisition profile " + path);
+    }
+}
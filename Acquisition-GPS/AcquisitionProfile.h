@@ -0,0 +1,40 @@
+#ifndef ACQUISITION_PROFILE_H
+#define ACQUISITION_PROFILE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "SettingsGps.h"
+
+// Per-machine engine configuration chosen by AutotuneAcquisition. A profile file holds one
+// section per host, so machines sharing a directory can share the file:
+//
+//   [hostname]
+//   require samplingFreq=38192000   conditions the section was tuned under
+//   acqPrecision=float              tuned settings, applied with setSetting()
+//
+// Lines starting with '#' are comments.
+
+using ProfileEntries = std::vector<std::pair<std::string, std::string>>;
+
+// Settings the autotuner chooses: resampling and FFT size, precision, threads, tile size and
+// FFTW planning effort
+ProfileEntries tunedAcquisitionSettings(const Settings& settings);
+
+// Settings a profile is only valid for: rates, code, search grid and the settings that change
+// the engine or the detection decision (circular-shift search, fine frequency, threshold, PRNs)
+ProfileEntries acquisitionProfileConditions(const Settings& settings);
+
+// Name of this machine, the section of its profile
+std::string profileHostName();
+
+// Apply the section of this host in path to settings. Returns false and leaves settings unchanged
+// if there is no file or no section for this host, or if the section was tuned under other
+// conditions (reported on stderr). Throws invalid_argument on a malformed section.
+bool loadAcquisitionProfile(const std::string& path, Settings& settings);
+
+// Write the tuned settings and conditions of settings as the section of this host, keeping the
+// sections of other hosts
+void saveAcquisitionProfile(const std::string& path, const Settings& settings);
+
+#endif // ACQUISITION_PROFILE_H
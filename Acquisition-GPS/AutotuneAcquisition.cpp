@@ -0,0 +1,393 @@
+/*
+########################################################################
+# AutotuneAcquisition.cpp:
+# Choose the fastest acquisition engine configuration of this machine
+#
+#  Project:        sw-rcvr-c++
+#  File:           AutotuneAcquisition.cpp
+#
+#  Usage: AutotuneAcquisition [minSeconds per candidate] [seed] [name=value ...]
+#
+#  The candidates are timed on a synthetic signal at the Settings rates
+#  (with the name=value overrides applied), one choice at a time: FFT size
+#  (resampling to a power of two or not) with precision, FFTW planning
+#  effort, threads, then tile size. A candidate is rejected if, on any of
+#  tuningRecordings recordings with satellites down to the detection
+#  threshold, its detections differ from the double precision search at
+#  the input rate or it loses peak metric or C/N0 against it. The fastest
+#  valid configuration is written to Settings::acqProfileFile, which
+#  AcquisitionGps applies at start-up on this machine.
+#
+########################################################################
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <complex>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "SettingsGps.h"
+#include "Acquisition.h"
+#include "AcquisitionProfile.h"
+#include "FftPlanCache.h"
+#include "SampleSource.h"
+#include "SignalGenerator.h"
+
+// A candidate must be this much faster than the best so far to replace it, so timing noise does
+// not pick a configuration over an equally fast one tried earlier
+constexpr double improvementMargin = 0.02;
+
+// Recordings (seeds seed, seed + 1, ...) a candidate must detect like the reference; the first
+// one is also the one timed
+constexpr int tuningRecordings = 3;
+
+// Loss against the reference a candidate may have on every satellite the reference acquires:
+// peak metric ratio and C/N0 [dB], about 1 dB. Threads, tiles, planning effort and precision
+// leave both unchanged; a coarser delay grid loses correlation peak (up to 2.5 dB at 2 samples
+// per chip, 0.6 dB at 8).
+constexpr double peakMetricTolerance = 0.8;
+constexpr double cn0ToleranceDb = 1.0;
+
+// C/N0 of the tuning satellites [dB-Hz]: two strong ones the reference must find, and four from
+// just above the detection threshold of the default search down to it
+constexpr double tuningCn0[] = {50.0, 47.0, 45.0, 44.0, 43.0, 42.0};
+constexpr double requiredCn0 = 46.0;
+
+// One recording to tune on, in both precisions
+struct TuningSignal {
+    std::vector<SyntheticSatellite> satellites;
+    std::vector<std::complex<double>> doubleSamples;
+    std::vector<std::complex<float>> singleSamples;
+};
+
+struct Measurement {
+    bool valid = false;
+    std::string reason;          // Why the candidate was rejected
+    double firstSeconds = 0.0;   // First search, with FFT planning and code spectra
+    double seconds = std::numeric_limits<double>::infinity();  // Per search afterwards
+};
+
+// Discard the progress output of the searches while in scope
+class QuietOutput {
+public:
+    QuietOutput() : saved(std::cout.rdbuf(sink.rdbuf())) {}
+    ~QuietOutput() { std::cout.rdbuf(saved); }
+
+private:
+    std::ostringstream sink;
+    std::streambuf* saved;
+};
+
+// Up to six PRNs of satMask spread over it, at Dopplers and code delays spread over the search
+// grid, at the tuningCn0 levels. The signal carries no navigation data: a bit edge inside a 1 ms
+// block can move the peak to another frequency bin in any configuration, which would reject it
+// for reasons that have nothing to do with the engine.
+static std::vector<SyntheticSatellite> tuningSatellites(const Settings& settings, int samplesPerCode) {
+    std::vector<SyntheticSatellite> satellites;
+    size_t count = std::min(std::size(tuningCn0), settings.satMask.size());
+    double dopplerRange = settings.acqFreqRangekHz * 1000.0 / 2 - 1000.0;
+    for (size_t i = 0; i < count; ++i) {
+        SyntheticSatellite satellite;
+        satellite.PRN = settings.satMask[i * settings.satMask.size() / count];
+        satellite.doppler = std::round((-0.8 + 1.6 * i / count) * dopplerRange) + 37.0;
+        satellite.codeDelay = std::round((0.13 + 0.79 * i / count) * samplesPerCode);
+        satellite.CN0 = tuningCn0[i];
+        satellites.push_back(satellite);
+    }
+    return satellites;
+}
+
+static TuningSignal makeSignal(const Settings& settings, uint64_t seed) {
+    int samplesPerCode = std::round(settings.samplingFreq * settings.codeLength / settings.codeFreqBasis);
+    Settings resampled = settings;
+    resampled.acqResample = true;
+    size_t numSamples = std::max(acquisitionSampleCount(settings), acquisitionSampleCount(resampled));
+
+    TuningSignal signal;
+    signal.satellites = tuningSatellites(settings, samplesPerCode);
+    std::vector<int8_t> raw(numSamples);
+    SignalGenerator(settings, signal.satellites, seed, 8.0, false).generate(0, numSamples, raw.data());
+    signal.doubleSamples.resize(numSamples);
+    signal.singleSamples.resize(numSamples);
+    convertSamples(SampleFormat::Int8Real, raw.data(), numSamples, signal.doubleSamples.data());
+    convertSamples(SampleFormat::Int8Real, raw.data(), numSamples, signal.singleSamples.data());
+    return signal;
+}
+
+static AcqResults search(const Settings& settings, const TuningSignal& signal) {
+    QuietOutput quiet;
+    return settings.acqPrecision == "float" ? searchGpsL1C(settings, signal.singleSamples)
+                                            : searchGpsL1C(settings, signal.doubleSamples);
+}
+
+static std::string describe(const Settings& settings) {
+    std::ostringstream text;
+    if (settings.acqResample) {
+        text << "resampled to " << std::lround(searchSamplingFrequency(settings) * settings.codeLength /
+                                               settings.codeFreqBasis) << "/code";
+    } else {
+        text << "input rate";
+    }
+    text << ", " << settings.acqPrecision << ", " << settings.fftPlanningEffort << ", "
+         << settings.acqThreads << " threads, tiles " << settings.acqTileBins << " bins x "
+         << settings.acqTilePrns << " PRNs";
+    return text.str();
+}
+
+// Satellite of satellites with PRN, or nullptr
+static const SyntheticSatellite* findSatellite(const std::vector<SyntheticSatellite>& satellites, int PRN) {
+    const SyntheticSatellite* truth = nullptr;
+    for (const SyntheticSatellite& satellite : satellites) {
+        truth = satellite.PRN == PRN ? &satellite : truth;
+    }
+    return truth;
+}
+
+// PRN is acquired where truth was generated: Doppler within a quarter of the inverse coherent
+// time (bins closer than that are within the noise of each other) or one bin, and code delay
+// within one sample of the search delay grid plus one input sample (a resampled search only
+// resolves its own, coarser grid)
+static bool detected(const Settings& settings, const AcqResults& results, int PRN, const SyntheticSatellite* truth) {
+    int samplesPerCode = std::round(settings.samplingFreq * settings.codeLength / settings.codeFreqBasis);
+    double dopplerTolerance = std::max(settings.acqFreqStepHz, 250.0) / settings.acqCoherentMs;
+    double delayTolerance = settings.samplingFreq / searchSamplingFrequency(settings) + 1.0;
+    return truth && results.acquired[PRN] &&
+           std::abs(results.carrFreq[PRN] - settings.IF - truth->doppler) <= dopplerTolerance &&
+           std::abs(std::remainder(results.codeDelay[PRN] - truth->codeDelay, samplesPerCode)) <= delayTolerance;
+}
+
+// Empty if candidate detects the satellites like the reference: every satellite the reference
+// detects, with its peak metric and C/N0 within the tolerances, and no false alarm the reference
+// does not have. Near the threshold the noise decides some detections either way, so a satellite
+// only the candidate detects is accepted.
+static std::string compareDetections(const Settings& candidate, const AcqResults& results,
+                                     const Settings& referenceSettings, const AcqResults& reference,
+                                     const std::vector<SyntheticSatellite>& satellites) {
+    for (int PRN : referenceSettings.satMask) {
+        std::string prn = "PRN " + std::to_string(PRN);
+        const SyntheticSatellite* truth = findSatellite(satellites, PRN);
+        bool found = detected(candidate, results, PRN, truth);
+        if (!found && results.acquired[PRN] && !reference.acquired[PRN]) {
+            return prn + " false alarm";
+        }
+        if (!detected(referenceSettings, reference, PRN, truth)) {
+            continue;
+        }
+        if (!found) {
+            return prn + (results.acquired[PRN] ? " detected at another Doppler or code delay" : " missed");
+        }
+        if (results.peakMetric[PRN] < reference.peakMetric[PRN] * peakMetricTolerance) {
+            return prn + " peak metric " + std::to_string(results.peakMetric[PRN]) + " against " +
+                   std::to_string(reference.peakMetric[PRN]);
+        }
+        if (results.SNR[PRN] < reference.SNR[PRN] - cn0ToleranceDb) {
+            return prn + " C/N0 " + std::to_string(results.SNR[PRN]) + " dB-Hz against " +
+                   std::to_string(reference.SNR[PRN]);
+        }
+    }
+    return "";
+}
+
+// The reference search must detect the satellites of at least requiredCn0
+static void checkReference(const Settings& settings, const AcqResults& reference,
+                           const std::vector<SyntheticSatellite>& satellites) {
+    for (const SyntheticSatellite& satellite : satellites) {
+        if (satellite.CN0 >= requiredCn0 && !detected(settings, reference, satellite.PRN, &satellite)) {
+            throw std::runtime_error("The reference search does not detect the tuning signal correctly (PRN " +
+                                     std::to_string(satellite.PRN) + "); check the acquisition settings");
+        }
+    }
+}
+
+// Time candidate: a first search, checked against the reference like the searches of the other
+// recordings, then searches of the first recording for at least minSeconds. The plan cache keys
+// plans by planning effort, so the first search of a new effort includes its planning.
+static Measurement measure(const Settings& candidate, const std::vector<TuningSignal>& signals, double minSeconds,
+                           const Settings& referenceSettings, const std::vector<AcqResults>& references) {
+    Measurement measurement;
+    auto start = std::chrono::steady_clock::now();
+    AcqResults results = search(candidate, signals[0]);
+    measurement.firstSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (size_t i = 0; i < signals.size(); ++i) {
+        if (i > 0) {
+            results = search(candidate, signals[i]);
+        }
+        measurement.reason = compareDetections(candidate, results, referenceSettings, references[i],
+                                                  signals[i].satellites);
+        if (!measurement.reason.empty()) {
+            measurement.reason += signals.size() > 1 ? " (recording " + std::to_string(i + 1) + ")" : "";
+            return measurement;
+        }
+    }
+    const TuningSignal& signal = signals[0];
+
+    size_t calls = 0;
+    double elapsed = 0.0;
+    start = std::chrono::steady_clock::now();
+    do {
+        results = search(candidate, signal);
+        ++calls;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    measurement.valid = true;
+    measurement.seconds = elapsed / calls;
+    return measurement;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        double minSeconds = argc > 1 ? std::stod(argv[1]) : 1.0;
+        uint64_t seed = argc > 2 ? std::stoull(argv[2]) : 1;
+
+        // Settings as AcquisitionGps starts with them, before any profile
+        Settings settings;
+        for (int i = 3; i < argc; ++i) {
+            std::string assignment = argv[i];
+            size_t equals = assignment.find('=');
+            if (equals == std::string::npos) {
+                throw std::invalid_argument("Expected name=value, got " + assignment);
+            }
+            setSetting(settings, assignment.substr(0, equals), assignment.substr(equals + 1));
+        }
+        settings.acqDumpResults = false;
+        settings.acqValidatePrecision = false;
+        if (settings.acqProfileFile.empty()) {
+            throw std::invalid_argument("acqProfileFile is empty: nowhere to write the profile");
+        }
+
+        std::vector<TuningSignal> signals;
+        for (int i = 0; i < tuningRecordings; ++i) {
+            signals.push_back(makeSignal(settings, seed + i));
+        }
+        std::cout << "Tuning signal at " << settings.samplingFreq / 1e6 << " MHz, " << tuningRecordings
+                  << " recordings:";
+        for (const SyntheticSatellite& satellite : signals[0].satellites) {
+            std::cout << " PRN " << satellite.PRN << " (" << satellite.doppler << " Hz, " << satellite.CN0
+                      << " dB-Hz)";
+        }
+        std::cout << std::endl;
+
+        // Reference detections: double precision at the input rate
+        Settings referenceSettings = settings;
+        referenceSettings.acqPrecision = "double";
+        referenceSettings.acqResample = false;
+        std::vector<AcqResults> references;
+        for (const TuningSignal& signal : signals) {
+            references.push_back(search(referenceSettings, signal));
+            checkReference(referenceSettings, references.back(), signal.satellites);
+        }
+
+        Settings best = settings;
+        Measurement baseline = measure(best, signals, minSeconds, referenceSettings, references);
+        Measurement bestTime = baseline;
+        std::cout << std::fixed << std::setprecision(1) << "Current settings: " << describe(best) << ": ";
+        if (baseline.valid) {
+            std::cout << baseline.seconds * 1e3 << " ms" << std::endl;
+        } else {
+            std::cout << "rejected: " << baseline.reason << std::endl;
+        }
+
+        // Time the candidates of one choice and keep the fastest valid one
+        auto tune = [&](const std::string& choice, const std::vector<Settings>& candidates) {
+            std::cout << choice << ":" << std::endl;
+            for (const Settings& candidate : candidates) {
+                if (describe(candidate) == describe(best)) {
+                    continue;
+                }
+                Measurement measurement = measure(candidate, signals, minSeconds, referenceSettings, references);
+                std::cout << "  " << describe(candidate) << ": ";
+                if (!measurement.valid) {
+                    std::cout << "rejected: " << measurement.reason << std::endl;
+                    continue;
+                }
+                std::cout << measurement.seconds * 1e3 << " ms (first search " << measurement.firstSeconds * 1e3
+                          << " ms)" << std::endl;
+                if (measurement.seconds < bestTime.seconds * (1.0 - improvementMargin)) {
+                    best = candidate;
+                    bestTime = measurement;
+                }
+            }
+        };
+
+        // FFT size and precision together: single precision gains more on the larger transforms
+        std::vector<Settings> candidates;
+        int inputSamplesPerCode = std::round(settings.samplingFreq * settings.codeLength / settings.codeFreqBasis);
+        for (int samplesPerCode : {0, nextPowerOf2(2 * settings.codeLength), nextPowerOf2(4 * settings.codeLength),
+                                   nextPowerOf2(8 * settings.codeLength)}) {
+            if (samplesPerCode >= inputSamplesPerCode) {
+                continue;
+            }
+            for (const char* precision : {"float", "double"}) {
+                Settings candidate = best;
+                candidate.acqResample = samplesPerCode > 0;
+                candidate.acqResampledSamplesPerCode = samplesPerCode;
+                candidate.acqPrecision = precision;
+                candidates.push_back(candidate);
+            }
+        }
+        tune("FFT size and precision", candidates);
+
+        // Patient planning only for power-of-two transforms, where it finishes in seconds
+        candidates.clear();
+        std::vector<std::string> efforts = {"estimate", "measure"};
+        if (best.acqResample) {
+            efforts.push_back("patient");
+        }
+        for (const std::string& effort : efforts) {
+            Settings candidate = best;
+            candidate.fftPlanningEffort = effort;
+            candidates.push_back(candidate);
+        }
+        tune("FFTW planning effort", candidates);
+
+        candidates.clear();
+        int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+        for (int threads = 1; threads < 2 * hardwareThreads; threads *= 2) {
+            Settings candidate = best;
+            candidate.acqThreads = std::min(threads, hardwareThreads);
+            candidates.push_back(candidate);
+        }
+        tune("Threads", candidates);
+
+        candidates.clear();
+        for (int tileBins : {1, 2, 4, 8}) {
+            Settings candidate = best;
+            candidate.acqTileBins = tileBins;
+            candidates.push_back(candidate);
+        }
+        tune("Frequency bins per tile", candidates);
+
+        candidates.clear();
+        for (int tilePrns : {0, 1, 4, 8}) {
+            if (tilePrns < static_cast<int>(settings.satMask.size())) {
+                Settings candidate = best;
+                candidate.acqTilePrns = tilePrns;
+                candidates.push_back(candidate);
+            }
+        }
+        tune("PRNs per tile", candidates);
+
+        if (!bestTime.valid) {
+            throw std::runtime_error("No candidate configuration detects the tuning signal like the reference");
+        }
+        FftPlanCache::instance().release();
+        saveAcquisitionProfile(settings.acqProfileFile, best);
+
+        std::cout << "Fastest: " << describe(best) << ": " << bestTime.seconds * 1e3 << " ms per search";
+        if (baseline.valid) {
+            std::cout << ", " << std::setprecision(2) << baseline.seconds / bestTime.seconds << " x the current settings";
+        }
+        std::cout << std::endl;
+        std::cout << "Profile for " << profileHostName() << " written to " << settings.acqProfileFile << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
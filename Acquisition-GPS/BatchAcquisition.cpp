@@ -0,0 +1,251 @@
+/*
+########################################################################
+# BatchAcquisition.cpp:
+# Acquisition of a manifest of recordings on a shared pool
+#
+#  Project:        sw-rcvr-c++
+#  File:           BatchAcquisition.cpp
+#
+########################################################################
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include "BatchAcquisition.h"
+#include "SampleSource.h"
+#include "WorkStealingPool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Search input of one job, converted by the reader thread
+struct LoadedFile {
+    std::vector<std::complex<float>> singleSamples;
+    std::vector<std::complex<double>> doubleSamples;
+    std::string error;
+};
+
+// Samples the search of job reads, in its precision
+LoadedFile loadJob(const BatchJob& job) {
+    LoadedFile file;
+    try {
+        const Settings& settings = job.settings;
+        SampleSource source(settings.inputFile, parseSampleFormat(settings.dataType));
+        size_t count = acquisitionSampleCount(settings);
+        if (source.size() < count) {
+            throw std::runtime_error("Recording too short: " + std::to_string(source.size()) + " samples, " +
+                                     std::to_string(count) + " needed");
+        }
+        if (settings.acqPrecision == "float") {
+            file.singleSamples = source.read<float>(0, count);
+        } else if (settings.acqPrecision == "double") {
+            file.doubleSamples = source.read<double>(0, count);
+        } else {
+            throw std::invalid_argument("Unknown acquisition precision: " + settings.acqPrecision);
+        }
+    } catch (const std::exception& e) {
+        file.error = e.what();
+    }
+    return file;
+}
+
+// CSV field between quotes, with embedded quotes doubled
+std::string quoted(const std::string& text) {
+    std::string field = "\"";
+    for (char c : text) {
+        field += c == '"' ? "\"\"" : std::string(1, c);
+    }
+    return field + "\"";
+}
+
+void writeRows(std::ofstream& csv, const BatchFileResult& result) {
+    const Settings& settings = result.job->settings;
+    if (result.failed) {
+        csv << quoted(settings.inputFile) << ",,,,,,," << quoted(result.error) << "\n";
+        return;
+    }
+    const AcqResults& acqResults = result.acqResults;
+    for (int PRN : settings.satMask) {
+        csv << quoted(settings.inputFile) << "," << PRN << "," << acqResults.acquired[PRN] << ",";
+        if (acqResults.acquired[PRN]) {
+            csv << acqResults.carrFreq[PRN] - settings.IF << "," << acqResults.codeDelay[PRN] << ","
+                << acqResults.peakMetric[PRN] << "," << acqResults.SNR[PRN] << ",\n";
+        } else {
+            csv << ",," << acqResults.peakMetric[PRN] << ",,\n";
+        }
+    }
+}
+
+}
+
+std::vector<BatchJob> loadBatchManifest(const std::string& path, const Settings& base) {
+    std::ifstream manifest(path);
+    if (!manifest) {
+        throw std::runtime_error("Cannot open batch manifest " + path);
+    }
+    fs::path directory = fs::path(path).parent_path();
+
+    std::vector<BatchJob> jobs;
+    std::string text;
+    for (size_t line = 1; std::getline(manifest, text); ++line) {
+        std::istringstream fields(text.substr(0, text.find('#')));
+        std::string recording;
+        if (!(fields >> recording)) {
+            continue;
+        }
+
+        BatchJob job;
+        job.line = line;
+        job.settings = base;
+        job.settings.inputFile = fs::path(recording).is_absolute() ? recording : (directory / recording).string();
+        job.settings.acqDumpResults = false;
+        job.settings.acqSearchSpaceStorage = "summary";
+
+        std::string assignment;
+        while (fields >> assignment) {
+            size_t equals = assignment.find('=');
+            if (equals == std::string::npos || equals == 0) {
+                throw std::invalid_argument(path + ":" + std::to_string(line) + ": expected name=value, got " +
+                                            assignment);
+            }
+            try {
+                setSetting(job.settings, assignment.substr(0, equals), assignment.substr(equals + 1));
+            } catch (const std::invalid_argument& e) {
+                throw std::invalid_argument(path + ":" + std::to_string(line) + ": " + e.what());
+            }
+        }
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
+
+std::string batchOutputPath(const Settings& settings) {
+    return settings.batchOutputFile.empty() ? settings.batchManifest + ".csv" : settings.batchOutputFile;
+}
+
+BatchStatistics batchAcquisition(const Settings& settings, const std::vector<BatchJob>& jobs,
+                                 const BatchCallback& onFile) {
+    std::string outputPath = batchOutputPath(settings);
+    std::ofstream csv(outputPath);
+    if (!csv) {
+        throw std::runtime_error("Cannot write " + outputPath);
+    }
+    csv << std::setprecision(10) << "file,PRN,acquired,doppler_Hz,code_delay_samples,peak_metric,cn0_dBHz,error\n";
+
+    BatchStatistics stats;
+    stats.jobs = jobs.size();
+    auto start = Clock::now();
+    WorkStealingPool pool(settings.acqThreads);
+
+    // Reader thread: converted input of the next recordings, at most prefetch of them at a time
+    size_t prefetch = std::max(settings.batchPrefetchFiles, 1);
+    std::mutex mutex;
+    std::condition_variable fileRead, fileTaken;
+    std::deque<LoadedFile> loaded;
+    bool stopping = false;
+
+    std::thread reader([&] {
+        for (const BatchJob& job : jobs) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                fileTaken.wait(lock, [&] { return stopping || loaded.size() < prefetch; });
+                if (stopping) {
+                    return;
+                }
+            }
+            LoadedFile file = loadJob(job);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                loaded.push_back(std::move(file));
+            }
+            fileRead.notify_one();
+        }
+    });
+
+    auto consume = [&] {
+        for (size_t index = 0; index < jobs.size(); ++index) {
+            BatchFileResult result;
+            result.index = index;
+            result.job = &jobs[index];
+            const Settings& jobSettings = jobs[index].settings;
+
+            LoadedFile file;
+            auto waitStart = Clock::now();
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                fileRead.wait(lock, [&] { return !loaded.empty(); });
+                file = std::move(loaded.front());
+                loaded.pop_front();
+            }
+            fileTaken.notify_one();
+            auto searchStart = Clock::now();
+            result.loadWaitSeconds = std::chrono::duration<double>(searchStart - waitStart).count();
+
+            try {
+                if (!file.error.empty()) {
+                    throw std::runtime_error(file.error);
+                }
+                stats.bytesRead += file.singleSamples.size() * sizeof(std::complex<float>) +
+                                   file.doubleSamples.size() * sizeof(std::complex<double>);
+                result.acqResults = file.singleSamples.empty()
+                    ? searchGpsL1C(jobSettings, file.doubleSamples, AcquisitionCallback(), &pool)
+                    : searchGpsL1C(jobSettings, file.singleSamples, AcquisitionCallback(), &pool);
+                if (jobSettings.acqDumpResults) {
+                    result.acqResults.dump(jobSettings, acquisitionOutputDir(jobSettings));
+                }
+            } catch (const std::exception& e) {
+                result.failed = true;
+                result.error = e.what();
+                result.acqResults = AcqResults();
+            }
+            result.searchSeconds = std::chrono::duration<double>(Clock::now() - searchStart).count();
+
+            stats.failed += result.failed;
+            stats.loadWaitSeconds += result.loadWaitSeconds;
+            if (!result.failed) {
+                for (int PRN : jobSettings.satMask) {
+                    stats.acquired += result.acqResults.acquired[PRN];
+                }
+            }
+
+            writeRows(csv, result);
+            csv.flush();
+            if (!csv) {
+                throw std::runtime_error("Cannot write " + outputPath);
+            }
+            if (onFile) {
+                onFile(result);
+            }
+        }
+    };
+
+    // Stop the reader if the batch itself fails (output file, callback)
+    try {
+        consume();
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        fileTaken.notify_all();
+        reader.join();
+        throw;
+    }
+    reader.join();
+
+    stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,60 @@
+#ifndef BATCH_ACQUISITION_H
+#define BATCH_ACQUISITION_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include "SettingsGps.h"
+#include "Acquisition.h"
+
+// One recording of a batch with its own settings
+struct BatchJob {
+    Settings settings;  // Base settings with the overrides of the manifest line; inputFile is the recording
+    size_t line = 0;    // Manifest line, for messages
+};
+
+// Read a batch manifest: one recording per line, "path [name=value ...]", with the overrides
+// applied through setSetting() on top of base. Paths are relative to the manifest directory;
+// blank lines and text after '#' are ignored. Batch jobs default to acqDumpResults = false and
+// acqSearchSpaceStorage = "summary" (only the peaks are kept), which a line can override.
+// Throws invalid_argument with the line number on a malformed line or an unknown setting.
+std::vector<BatchJob> loadBatchManifest(const std::string& path, const Settings& base);
+
+// Consolidated results file of a batch: settings.batchOutputFile, or batchManifest + ".csv"
+std::string batchOutputPath(const Settings& settings);
+
+// Outcome of one recording
+struct BatchFileResult {
+    size_t index = 0;        // Job index in manifest order
+    const BatchJob* job = nullptr;
+    bool failed = false;     // The recording could not be read or searched; see error
+    std::string error;
+    double loadWaitSeconds = 0.0;  // Time the search waited for the recording to be read
+    double searchSeconds = 0.0;
+    AcqResults acqResults;   // Empty if failed
+};
+
+// Totals of a batch
+struct BatchStatistics {
+    size_t jobs = 0;
+    size_t failed = 0;
+    size_t acquired = 0;           // Satellites acquired, summed over the recordings
+    size_t bytesRead = 0;          // Search input converted, in the precision of each search
+    double seconds = 0.0;
+    double loadWaitSeconds = 0.0;  // Time the searches waited for input (prefetch too shallow or disk bound)
+};
+
+using BatchCallback = std::function<void(const BatchFileResult&)>;
+
+// Acquire every job in order in one process. All searches run on one pool of
+// settings.acqThreads threads (the per-job acqThreads is not used) and share the FFTW plans and
+// code spectra of equal search geometries. A reader thread maps each recording and converts the
+// samples the search needs, up to settings.batchPrefetchFiles recordings ahead of the search.
+// A job that fails is reported and the batch goes on. Every searched PRN of every recording is
+// written to batchOutputPath(settings) as soon as its recording is done, and onFile is called
+// with the results.
+BatchStatistics batchAcquisition(const Settings& settings, const std::vector<BatchJob>& jobs,
+                                 const BatchCallback& onFile = BatchCallback());
+
+#endif // BATCH_ACQUISITION_H
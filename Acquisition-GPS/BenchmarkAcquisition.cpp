@@ -0,0 +1,168 @@
+/*
+########################################################################
+# BenchmarkAcquisition.cpp:
+# Acquisition kernels and full search on a synthetic signal
+#
+#  Project:        sw-rcvr-c++
+#  File:           BenchmarkAcquisition.cpp
+#
+#  Usage: BenchmarkAcquisition [minSeconds per benchmark] [seed]
+#
+########################################################################
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <complex>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include "SettingsGps.h"
+#include "Acquisition.h"
+#include "CarrierNco.h"
+#include "FftPlanCache.h"
+#include "Goldencodes.h"
+#include "SampleSource.h"
+#include "SignalGenerator.h"
+
+// Known satellites of the benchmark signal
+static const std::vector<SyntheticSatellite> benchmarkSatellites = {
+    {3, 1250.0, 1200.0, 52.0}, {11, -2730.0, 20480.0, 51.0}, {19, 405.0, 5555.0, 53.0}, {27, 3310.0, 31000.0, 50.0}};
+
+// Seconds per call of run, repeated for at least minSeconds after a warm-up call
+template <typename Function>
+static double secondsPerCall(double minSeconds, Function&& run) {
+    run();
+    size_t calls = 0;
+    double elapsed = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    do {
+        run();
+        ++calls;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    return elapsed / calls;
+}
+
+static void report(const std::string& name, double value, const std::string& unit) {
+    std::cout << std::left << std::setw(40) << name << std::right << std::setw(12) << std::fixed
+              << std::setprecision(3) << value << " " << unit << std::endl;
+}
+
+// Carrier wipe-off of one code period
+template <typename T>
+static void benchmarkWipeOff(const std::vector<std::complex<T>>& signal, int samplesPerCode, double carrFreq,
+                             double samplingFreq, double minSeconds, const std::string& name) {
+    std::vector<std::complex<T>> output(samplesPerCode);
+    const std::complex<T>* in = signal.data();
+    std::complex<T>* out = output.data();
+    double seconds = secondsPerCall(minSeconds, [&] { carrierWipeOff(&in, &out, 1, samplesPerCode, carrFreq, samplingFreq); });
+    report(name, seconds * 1e9 / samplesPerCode, "ns/sample");
+}
+
+// Correlation of one code period with a code replica through the DFT: forward transform,
+// product with the conjugate code spectrum and inverse transform
+template <typename T>
+static void benchmarkFftCorrelation(const std::vector<std::complex<T>>& signal, const Settings& settings,
+                                    int samplesPerCode, double minSeconds, const std::string& name) {
+    using Complex = typename Fftw<T>::Complex;
+    typename Fftw<T>::Buffer codeSpectrum = Fftw<T>::alloc(samplesPerCode);
+    typename Fftw<T>::Buffer buffer = Fftw<T>::alloc(samplesPerCode);
+    std::complex<T>* code = reinterpret_cast<std::complex<T>*>(codeSpectrum.get());
+    std::complex<T>* data = reinterpret_cast<std::complex<T>*>(buffer.get());
+    auto forward = Fftw<T>::plan(samplesPerCode, FFTW_FORWARD);
+    auto backward = Fftw<T>::plan(samplesPerCode, FFTW_BACKWARD);
+
+    for (int i = 0; i < samplesPerCode; ++i) {
+        code[i] = caCodeSample(1, i, settings.samplingFreq, settings.codeFreqBasis);
+    }
+    Fftw<T>::execute(forward, codeSpectrum.get(), codeSpectrum.get());
+    for (int i = 0; i < samplesPerCode; ++i) {
+        code[i] = std::conj(code[i]);
+    }
+
+    double seconds = secondsPerCall(minSeconds, [&] {
+        std::copy(signal.begin(), signal.begin() + samplesPerCode, data);
+        Fftw<T>::execute(forward, buffer.get(), buffer.get());
+        for (int i = 0; i < samplesPerCode; ++i) {
+            data[i] *= code[i];
+        }
+        Fftw<T>::execute(backward, reinterpret_cast<Complex*>(data), reinterpret_cast<Complex*>(data));
+    });
+    report(name, seconds * 1e9 / samplesPerCode, "ns/sample");
+}
+
+// Full search, with the detections checked against the known satellites; false on a missed
+// satellite, a wrong Doppler or code delay or a false alarm
+template <typename T>
+static bool benchmarkAcquisition(const std::vector<std::complex<T>>& signal, const Settings& settings,
+                                 int samplesPerCode, double minSeconds, const std::string& name) {
+    AcqResults acqResults;
+    double seconds = secondsPerCall(minSeconds, [&] { acqResults = acquisitionGpsL1C(settings, signal); });
+    report(name, 1.0 / seconds, "acquisitions/s");
+    report(name, seconds * 1e9 / acquisitionSampleCount(settings), "ns/sample");
+
+    int missed = 0, wrong = 0, falseAlarms = 0;
+    for (int PRN : settings.satMask) {
+        const SyntheticSatellite* truth = nullptr;
+        for (const SyntheticSatellite& satellite : benchmarkSatellites) {
+            truth = satellite.PRN == PRN ? &satellite : truth;
+        }
+        if (!truth) {
+            falseAlarms += acqResults.acquired[PRN];
+            continue;
+        }
+        if (!acqResults.acquired[PRN]) {
+            ++missed;
+            continue;
+        }
+        double dopplerError = acqResults.carrFreq[PRN] - settings.IF - truth->doppler;
+        double delayError = std::remainder(acqResults.codeDelay[PRN] - truth->codeDelay, samplesPerCode);
+        std::cout << "  PRN " << PRN << ": Doppler error " << dopplerError << " Hz, code delay error " << delayError
+                  << " samples" << std::endl;
+        wrong += std::abs(dopplerError) > settings.acqFreqStepHz || std::abs(delayError) > 2.0;
+    }
+    std::cout << "  " << benchmarkSatellites.size() << " satellites: " << missed << " missed, " << wrong
+              << " wrong Doppler or code delay, " << falseAlarms << " false alarms" << std::endl;
+    return missed + wrong + falseAlarms == 0;
+}
+
+int main(int argc, char* argv[]) {
+    double minSeconds = argc > 1 ? std::stod(argv[1]) : 0.5;
+    uint64_t seed = argc > 2 ? std::stoull(argv[2]) : 1;
+
+    Settings settings;
+    settings.acqDumpResults = false;
+    int samplesPerCode = std::round(settings.samplingFreq * settings.codeLength / settings.codeFreqBasis);
+
+    // Same int8 samples as a recording written by GenerateSignal
+    size_t numSamples = acquisitionSampleCount(settings);
+    std::vector<int8_t> raw(numSamples);
+    SignalGenerator(settings, benchmarkSatellites, seed).generate(0, numSamples, raw.data());
+    std::vector<std::complex<double>> signal(numSamples);
+    std::vector<std::complex<float>> signalFloat(numSamples);
+    convertSamples(SampleFormat::Int8Real, raw.data(), numSamples, signal.data());
+    convertSamples(SampleFormat::Int8Real, raw.data(), numSamples, signalFloat.data());
+
+    double seconds = secondsPerCall(minSeconds, [&] {
+        for (int PRN = 1; PRN <= 32; ++PRN) {
+            generateGoldCode(PRN);
+        }
+    });
+    report("generateGoldCode", seconds * 1e9 / (32 * caCodeLength), "ns/chip");
+
+    double carrFreq = settings.IF + benchmarkSatellites[0].doppler;
+    benchmarkWipeOff(signal, samplesPerCode, carrFreq, settings.samplingFreq, minSeconds, "carrierWipeOff double");
+    benchmarkWipeOff(signalFloat, samplesPerCode, carrFreq, settings.samplingFreq, minSeconds, "carrierWipeOff float");
+    benchmarkFftCorrelation(signal, settings, samplesPerCode, minSeconds, "FFT correlation double");
+    benchmarkFftCorrelation(signalFloat, settings, samplesPerCode, minSeconds, "FFT correlation float");
+
+    settings.acqPrecision = "double";
+    bool detected = benchmarkAcquisition(signal, settings, samplesPerCode, minSeconds, "acquisitionGpsL1C double");
+    settings.acqPrecision = "float";
+    detected &= benchmarkAcquisition(signalFloat, settings, samplesPerCode, minSeconds, "acquisitionGpsL1C float");
+
+    FftPlanCache::instance().release();
+    return detected ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,296 @@
+/*
+########################################################################
+# BitCorrelator.cpp:
+# XOR and popcount correlator for 1- and 2-bit quantized samples
+#
+#  Project:        sw-rcvr-c++
+#  File:           BitCorrelator.cpp
+#
+########################################################################
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "BitCorrelator.h"
+#include "Goldencodes.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define BIT_CORRELATOR_X86 1
+#endif
+
+namespace {
+
+// Population counts of one period against a replica: I sign differences, I differences with
+// the magnitude bit set, and the same for Q
+using PopcountKernel = void (*)(const uint64_t* planes, const uint64_t* replica, int words, uint64_t counts[4]);
+
+inline void popcountPortableBody(const uint64_t* planes, const uint64_t* replica, int words, uint64_t counts[4]) {
+    const uint64_t* iSign = planes;
+    const uint64_t* iMag = planes + words;
+    const uint64_t* qSign = planes + 2 * words;
+    const uint64_t* qMag = planes + 3 * words;
+    uint64_t iDiff = 0, iDiffMag = 0, qDiff = 0, qDiffMag = 0;
+    for (int w = 0; w < words; ++w) {
+        uint64_t xI = iSign[w] ^ replica[w];
+        uint64_t xQ = qSign[w] ^ replica[w];
+        iDiff += __builtin_popcountll(xI);
+        iDiffMag += __builtin_popcountll(xI & iMag[w]);
+        qDiff += __builtin_popcountll(xQ);
+        qDiffMag += __builtin_popcountll(xQ & qMag[w]);
+    }
+    counts[0] = iDiff;
+    counts[1] = iDiffMag;
+    counts[2] = qDiff;
+    counts[3] = qDiffMag;
+}
+
+// Portable kernel (a bit-twiddling population count unless the compiler targets POPCNT)
+void popcountPortable(const uint64_t* planes, const uint64_t* replica, int words, uint64_t counts[4]) {
+    popcountPortableBody(planes, replica, words, counts);
+}
+
+#ifdef BIT_CORRELATOR_X86
+
+// Same loop with the POPCNT instruction
+__attribute__((target("popcnt")))
+void popcountScalar(const uint64_t* planes, const uint64_t* replica, int words, uint64_t counts[4]) {
+    popcountPortableBody(planes, replica, words, counts);
+}
+
+// GCC 12 reports _mm256_undefined_si256() inside _mm512_reduce_add_epi64 as uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+
+// AVX-512 VPOPCNTDQ kernel: 8 words of every plane per iteration (words is a multiple of 8)
+__attribute__((target("avx512f,avx512vpopcntdq")))
+void popcountAvx512(const uint64_t* planes, const uint64_t* replica, int words, uint64_t counts[4]) {
+    __m512i iDiff = _mm512_setzero_si512(), iDiffMag = _mm512_setzero_si512();
+    __m512i qDiff = _mm512_setzero_si512(), qDiffMag = _mm512_setzero_si512();
+    for (int w = 0; w < words; w += 8) {
+        __m512i code = _mm512_loadu_si512(replica + w);
+        __m512i xI = _mm512_xor_si512(_mm512_loadu_si512(planes + w), code);
+        __m512i xQ = _mm512_xor_si512(_mm512_loadu_si512(planes + 2 * words + w), code);
+        iDiff = _mm512_add_epi64(iDiff, _mm512_popcnt_epi64(xI));
+        iDiffMag = _mm512_add_epi64(iDiffMag, _mm512_popcnt_epi64(_mm512_and_si512(xI, _mm512_loadu_si512(planes + words + w))));
+        qDiff = _mm512_add_epi64(qDiff, _mm512_popcnt_epi64(xQ));
+        qDiffMag = _mm512_add_epi64(qDiffMag, _mm512_popcnt_epi64(_mm512_and_si512(xQ, _mm512_loadu_si512(planes + 3 * words + w))));
+    }
+    counts[0] = _mm512_reduce_add_epi64(iDiff);
+    counts[1] = _mm512_reduce_add_epi64(iDiffMag);
+    counts[2] = _mm512_reduce_add_epi64(qDiff);
+    counts[3] = _mm512_reduce_add_epi64(qDiffMag);
+}
+
+// AVX-512 packing of one full word (64 samples): real and imaginary parts are separated with
+// a two-register permutation and compared into bit masks, 16 (float) or 8 (double) at a time
+__attribute__((target("avx512f")))
+void packWordAvx512(const std::complex<float>* x, float threshold, uint64_t words[4]) {
+    const __m512i realIndex = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i imagIndex = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 limit = _mm512_set1_ps(threshold);
+    uint64_t is = 0, im = 0, qs = 0, qm = 0;
+    for (int g = 0; g < 4; ++g) {
+        const float* values = reinterpret_cast<const float*>(x + 16 * g);
+        __m512 a = _mm512_loadu_ps(values);
+        __m512 b = _mm512_loadu_ps(values + 16);
+        __m512 re = _mm512_permutex2var_ps(a, realIndex, b);
+        __m512 imag = _mm512_permutex2var_ps(a, imagIndex, b);
+        is |= uint64_t(_mm512_cmp_ps_mask(re, zero, _CMP_LT_OQ)) << (16 * g);
+        qs |= uint64_t(_mm512_cmp_ps_mask(imag, zero, _CMP_LT_OQ)) << (16 * g);
+        im |= uint64_t(_mm512_cmp_ps_mask(_mm512_abs_ps(re), limit, _CMP_GT_OQ)) << (16 * g);
+        qm |= uint64_t(_mm512_cmp_ps_mask(_mm512_abs_ps(imag), limit, _CMP_GT_OQ)) << (16 * g);
+    }
+    words[0] = is;
+    words[1] = im;
+    words[2] = qs;
+    words[3] = qm;
+}
+
+__attribute__((target("avx512f")))
+void packWordAvx512(const std::complex<double>* x, double threshold, uint64_t words[4]) {
+    const __m512i realIndex = _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14);
+    const __m512i imagIndex = _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15);
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d limit = _mm512_set1_pd(threshold);
+    uint64_t is = 0, im = 0, qs = 0, qm = 0;
+    for (int g = 0; g < 8; ++g) {
+        const double* values = reinterpret_cast<const double*>(x + 8 * g);
+        __m512d a = _mm512_loadu_pd(values);
+        __m512d b = _mm512_loadu_pd(values + 8);
+        __m512d re = _mm512_permutex2var_pd(a, realIndex, b);
+        __m512d imag = _mm512_permutex2var_pd(a, imagIndex, b);
+        is |= uint64_t(_mm512_cmp_pd_mask(re, zero, _CMP_LT_OQ)) << (8 * g);
+        qs |= uint64_t(_mm512_cmp_pd_mask(imag, zero, _CMP_LT_OQ)) << (8 * g);
+        im |= uint64_t(_mm512_cmp_pd_mask(_mm512_abs_pd(re), limit, _CMP_GT_OQ)) << (8 * g);
+        qm |= uint64_t(_mm512_cmp_pd_mask(_mm512_abs_pd(imag), limit, _CMP_GT_OQ)) << (8 * g);
+    }
+    words[0] = is;
+    words[1] = im;
+    words[2] = qs;
+    words[3] = qm;
+}
+
+#pragma GCC diagnostic pop
+
+#endif // BIT_CORRELATOR_X86
+
+// Pick the widest kernel the CPU supports
+PopcountKernel selectKernel() {
+#ifdef BIT_CORRELATOR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512vpopcntdq")) {
+        return popcountAvx512;
+    }
+    if (__builtin_cpu_supports("popcnt")) {
+        return popcountScalar;
+    }
+#endif
+    return popcountPortable;
+}
+
+// Portable packing of count <= 64 samples into four words
+template <typename T>
+void packWordScalar(const std::complex<T>* x, int count, T threshold, uint64_t words[4]) {
+    uint64_t is = 0, im = 0, qs = 0, qm = 0;
+    for (int k = 0; k < count; ++k) {
+        T re = x[k].real(), imag = x[k].imag();
+        is |= uint64_t(re < 0) << k;
+        qs |= uint64_t(imag < 0) << k;
+        im |= uint64_t(std::abs(re) > threshold) << k;
+        qm |= uint64_t(std::abs(imag) > threshold) << k;
+    }
+    words[0] = is;
+    words[1] = im;
+    words[2] = qs;
+    words[3] = qm;
+}
+
+bool hasAvx512() {
+#ifdef BIT_CORRELATOR_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f");
+#else
+    return false;
+#endif
+}
+
+int paddedWords(int samplesPerCode) {
+    int words = (samplesPerCode + 63) / 64;
+    return (words + packedWordMultiple - 1) / packedWordMultiple * packedWordMultiple;
+}
+
+}
+
+template <typename T>
+void PackedSamples::pack(const std::complex<T>* samples, int numPeriods, int samplesPerCode, int bits) {
+    if (bits != 1 && bits != 2) {
+        throw std::invalid_argument("Packed samples must have 1 or 2 bits");
+    }
+    this->numPeriods = numPeriods;
+    this->samplesPerCode = samplesPerCode;
+    wordsPerPeriod = paddedWords(samplesPerCode);
+    data.assign(size_t(numPeriods) * 4 * wordsPerPeriod, 0);
+    magnitudeCounts.assign(2 * size_t(numPeriods), 0);
+
+    size_t numSamples = size_t(numPeriods) * samplesPerCode;
+    T threshold = std::numeric_limits<T>::infinity();
+    if (bits == 2) {
+        double power = 0.0;
+        for (size_t i = 0; i < numSamples; ++i) {
+            power += std::norm(samples[i]);
+        }
+        threshold = static_cast<T>(std::sqrt(power / (2.0 * numSamples)));
+    }
+
+    // Each word is built in registers, without branches
+    static const bool avx512 = hasAvx512();
+    for (int p = 0; p < numPeriods; ++p) {
+        const std::complex<T>* x = samples + size_t(p) * samplesPerCode;
+        uint64_t* iSign = data.data() + size_t(p) * 4 * wordsPerPeriod;
+        uint64_t* iMag = iSign + wordsPerPeriod;
+        uint64_t* qSign = iSign + 2 * wordsPerPeriod;
+        uint64_t* qMag = iSign + 3 * wordsPerPeriod;
+        int iCount = 0, qCount = 0;
+        for (int w = 0; w * 64 < samplesPerCode; ++w) {
+            int count = std::min(64, samplesPerCode - 64 * w);
+            uint64_t words[4];
+#ifdef BIT_CORRELATOR_X86
+            if (avx512 && count == 64) {
+                packWordAvx512(x + 64 * w, threshold, words);
+            } else
+#endif
+            {
+                packWordScalar(x + 64 * w, count, threshold, words);
+            }
+            iSign[w] = words[0];
+            iMag[w] = words[1];
+            qSign[w] = words[2];
+            qMag[w] = words[3];
+            iCount += __builtin_popcountll(words[1]);
+            qCount += __builtin_popcountll(words[3]);
+        }
+        magnitudeCounts[2 * size_t(p)] = iCount;
+        magnitudeCounts[2 * size_t(p) + 1] = qCount;
+    }
+}
+
+template void PackedSamples::pack(const std::complex<float>*, int, int, int);
+template void PackedSamples::pack(const std::complex<double>*, int, int, int);
+
+PackedCode::PackedCode(int PRN, const std::vector<int>& codeOversampIdx)
+    : samplesPerCode(codeOversampIdx.size()), wordsPerPeriod(paddedWords(samplesPerCode)) {
+    // Two periods, plus room for the funnel shift to read one word past the last delay
+    bits.assign(2 * size_t(wordsPerPeriod) + 2, 0);
+    const auto& chips = caCodeTable.chips.at(PRN);
+    for (int k = 0; k < 2 * samplesPerCode; ++k) {
+        if (chips[codeOversampIdx[k % samplesPerCode]] < 0) {
+            bits[k / 64] |= uint64_t(1) << (k % 64);
+        }
+    }
+}
+
+void PackedCode::replica(int delay, uint64_t* words) const {
+    size_t start = samplesPerCode - delay;  // Bit of sample 0, as in the doubled float replica
+    size_t first = start / 64;
+    int shift = start % 64;
+    for (int w = 0; w < wordsPerPeriod; ++w) {
+        uint64_t word = bits[first + w] >> shift;
+        if (shift != 0) {
+            word |= bits[first + w + 1] << (64 - shift);
+        }
+        int valid = samplesPerCode - 64 * w;
+        words[w] = valid >= 64 ? word : valid > 0 ? word & ((uint64_t(1) << valid) - 1) : 0;
+    }
+}
+
+template <typename T>
+void correlatePacked(const PackedSamples& samples, int coherentMs, const PackedCode& code, int firstDelay,
+                     int numDelays, std::complex<T>* out) {
+    static const PopcountKernel kernel = selectKernel();
+    int samplesPerCode = samples.samplesPerPeriod();
+    int words = samples.words();
+    int numBlocks = samples.periods() / coherentMs;
+    std::vector<uint64_t> replica(words);
+
+    for (int d = 0; d < numDelays; ++d) {
+        code.replica((firstDelay + d) % samplesPerCode, replica.data());
+        for (int block = 0; block < numBlocks; ++block) {
+            int64_t re = 0, im = 0;
+            for (int ms = 0; ms < coherentMs; ++ms) {
+                int p = block * coherentMs + ms;
+                uint64_t counts[4];
+                kernel(samples.period(p), replica.data(), words, counts);
+                re += samplesPerCode + 2 * int64_t(samples.magnitudeCount(p, 0)) - 2 * int64_t(counts[0]) - 4 * int64_t(counts[1]);
+                im += samplesPerCode + 2 * int64_t(samples.magnitudeCount(p, 1)) - 2 * int64_t(counts[2]) - 4 * int64_t(counts[3]);
+            }
+            out[size_t(block) * numDelays + d] = std::complex<T>(T(re), T(im));
+        }
+    }
+}
+
+template void correlatePacked(const PackedSamples&, int, const PackedCode&, int, int, std::complex<float>*);
+template void correlatePacked(const PackedSamples&, int, const PackedCode&, int, int, std::complex<double>*);
@@ -0,0 +1,74 @@
+#ifndef BIT_CORRELATOR_H
+#define BIT_CORRELATOR_H
+
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+// Bit-packed time-domain correlator for 1- and 2-bit quantized signals. Carrier-wiped samples are
+// quantized to a sign bit and, for 2 bits, a magnitude bit (levels +-1 and +-3) and packed 64
+// per word; the C/A replica is packed as one sign bit per sample. A sample times the replica is
+// then an XOR of sign bits, and a sum of products is a population count:
+//
+//     sum (1 - 2 x) (1 + 2 m) = N + 2 popcount(m) - 2 popcount(x) - 4 popcount(x & m),  x = s ^ c
+//
+// so one 64-bit word does the work of 64 multiply-adds. The population counts use AVX-512
+// VPOPCNTDQ when the CPU has it and a portable loop otherwise.
+
+// Words of a packed code period are padded to a multiple of this (one 512-bit vector)
+constexpr int packedWordMultiple = 8;
+
+// Carrier-wiped samples of a number of code periods, quantized and packed. Every period holds
+// the planes I sign, I magnitude, Q sign and Q magnitude, wordsPerPeriod words each; sign bits
+// are set for negative samples and padding bits are zero.
+class PackedSamples {
+public:
+    // Quantize numPeriods * samplesPerCode samples to bits (1 or 2) bits per component. The
+    // 2-bit magnitude threshold is the RMS of the components, close to the optimum for +-1, +-3.
+    // Implemented for float and double samples.
+    template <typename T>
+    void pack(const std::complex<T>* samples, int numPeriods, int samplesPerCode, int bits);
+
+    int periods() const { return numPeriods; }
+    int samplesPerPeriod() const { return samplesPerCode; }
+    int words() const { return wordsPerPeriod; }
+
+    // Planes of one code period
+    const uint64_t* period(int p) const { return data.data() + size_t(p) * 4 * wordsPerPeriod; }
+
+    // Set magnitude bits of the I (component 0) or Q (component 1) plane of a period
+    int magnitudeCount(int p, int component) const { return magnitudeCounts[2 * size_t(p) + component]; }
+
+private:
+    int numPeriods = 0, samplesPerCode = 0, wordsPerPeriod = 0;
+    std::vector<uint64_t> data;
+    std::vector<int> magnitudeCounts;
+};
+
+// Oversampled C/A replica of one PRN (codeOversampIdx maps samples to chips), packed over two
+// code periods so the replica at any delay is a funnel shift of consecutive words
+class PackedCode {
+public:
+    PackedCode() = default;
+    PackedCode(int PRN, const std::vector<int>& codeOversampIdx);
+
+    int words() const { return wordsPerPeriod; }
+
+    // Replica at a code delay (code[(i - delay) mod samplesPerCode] for sample i): words()
+    // words, with the bits past the code period cleared
+    void replica(int delay, uint64_t* words) const;
+
+private:
+    int samplesPerCode = 0, wordsPerPeriod = 0;
+    std::vector<uint64_t> bits;
+};
+
+// Correlate the packed periods with the code at numDelays consecutive delays from firstDelay
+// (circular), summing coherentMs consecutive periods into one block: out[block * numDelays + d].
+// The result is in quantization levels, so only ratios are comparable with the floating point
+// correlators. Implemented for float and double output.
+template <typename T>
+void correlatePacked(const PackedSamples& samples, int coherentMs, const PackedCode& code, int firstDelay,
+                     int numDelays, std::complex<T>* out);
+
+#endif // BIT_CORRELATOR_H
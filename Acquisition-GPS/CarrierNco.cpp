@@ -0,0 +1,278 @@
+/*
+########################################################################
+# CarrierNco.cpp:
+# Carrier generation and wipe-off kernels
+#
+#  Project:        sw-rcvr-c++
+#  File:           CarrierNco.cpp
+#
+########################################################################
+*/
+
+#include <cmath>
+#include <algorithm>
+#include "CarrierNco.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define CARRIER_NCO_X86 1
+#endif
+
+namespace {
+
+// Exact carrier replica sin(phase) + j*cos(phase) at sample i
+inline std::complex<double> carrierAt(double omega, long i) {
+    double phase = omega * i;
+    return {std::sin(phase), std::cos(phase)};
+}
+
+// Portable kernel: one phasor rotated by exp(-j*omega) per sample
+template <typename T>
+void carrierWipeOffScalar(const std::complex<T>* const* signals, std::complex<T>* const* outputs,
+                          int numBlocks, int numSamples, double omega) {
+    const std::complex<T> step(std::polar(1.0, -omega));
+
+    for (int start = 0; start < numSamples; start += ncoResetInterval) {
+        int end = std::min(start + ncoResetInterval, numSamples);
+        std::complex<T> carr(carrierAt(omega, start));
+        for (int i = start; i < end; ++i) {
+            for (int b = 0; b < numBlocks; ++b) {
+                outputs[b][i] = signals[b][i] * carr;
+            }
+            carr *= step;
+        }
+    }
+}
+
+// Exact carrier for the samples left over by the vector kernels
+template <typename T>
+void carrierWipeOffTail(const std::complex<T>* const* signals, std::complex<T>* const* outputs,
+                        int numBlocks, int first, int numSamples, double omega) {
+    for (int i = first; i < numSamples; ++i) {
+        std::complex<T> carr(carrierAt(omega, i));
+        for (int b = 0; b < numBlocks; ++b) {
+            outputs[b][i] = signals[b][i] * carr;
+        }
+    }
+}
+
+// Interleaved (re, im) initial phasors of samples start .. start + lanes - 1
+template <typename T, int lanes>
+void initialPhasors(double omega, int start, T* phasors) {
+    for (int l = 0; l < lanes; ++l) {
+        std::complex<double> c = carrierAt(omega, start + l);
+        phasors[2 * l] = static_cast<T>(c.real());
+        phasors[2 * l + 1] = static_cast<T>(c.imag());
+    }
+}
+
+#ifdef CARRIER_NCO_X86
+
+// Interleaved complex product of two registers of packed complex<double>
+__attribute__((target("avx2,fma")))
+inline __m256d complexMul(__m256d a, __m256d b) {
+    __m256d aRe = _mm256_movedup_pd(a);
+    __m256d aIm = _mm256_permute_pd(a, 0xF);
+    __m256d bSwap = _mm256_permute_pd(b, 0x5);
+    return _mm256_fmaddsub_pd(aRe, b, _mm256_mul_pd(aIm, bSwap));
+}
+
+// Interleaved complex product of two registers of packed complex<float>
+__attribute__((target("avx2,fma")))
+inline __m256 complexMul(__m256 a, __m256 b) {
+    __m256 aRe = _mm256_moveldup_ps(a);
+    __m256 aIm = _mm256_movehdup_ps(a);
+    __m256 bSwap = _mm256_permute_ps(b, 0xB1);
+    return _mm256_fmaddsub_ps(aRe, b, _mm256_mul_ps(aIm, bSwap));
+}
+
+// AVX2 kernel: 4 samples per iteration (two registers of 2 complex), phasors advance by exp(-j*4*omega)
+__attribute__((target("avx2,fma")))
+void carrierWipeOffAvx2(const std::complex<double>* const* signals, std::complex<double>* const* outputs,
+                        int numBlocks, int numSamples, double omega) {
+    constexpr int lanes = 4;
+    const std::complex<double> stepScalar = std::polar(1.0, -lanes * omega);
+    const __m256d step = _mm256_setr_pd(stepScalar.real(), stepScalar.imag(), stepScalar.real(), stepScalar.imag());
+
+    int vecEnd = numSamples - numSamples % lanes;
+    for (int start = 0; start < vecEnd; start += ncoResetInterval) {
+        int end = std::min(start + ncoResetInterval, vecEnd);
+
+        alignas(32) double init[2 * lanes];
+        initialPhasors<double, lanes>(omega, start, init);
+        __m256d carrLo = _mm256_load_pd(init);
+        __m256d carrHi = _mm256_load_pd(init + 4);
+
+        for (int i = start; i < end; i += lanes) {
+            for (int b = 0; b < numBlocks; ++b) {
+                const double* in = reinterpret_cast<const double*>(signals[b] + i);
+                double* out = reinterpret_cast<double*>(outputs[b] + i);
+                _mm256_storeu_pd(out, complexMul(_mm256_loadu_pd(in), carrLo));
+                _mm256_storeu_pd(out + 4, complexMul(_mm256_loadu_pd(in + 4), carrHi));
+            }
+            carrLo = complexMul(carrLo, step);
+            carrHi = complexMul(carrHi, step);
+        }
+    }
+
+    carrierWipeOffTail(signals, outputs, numBlocks, vecEnd, numSamples, omega);
+}
+
+// AVX2 single precision kernel: 8 samples per iteration (two registers of 4 complex)
+__attribute__((target("avx2,fma")))
+void carrierWipeOffAvx2(const std::complex<float>* const* signals, std::complex<float>* const* outputs,
+                        int numBlocks, int numSamples, double omega) {
+    constexpr int lanes = 8;
+    const std::complex<float> stepScalar(std::polar(1.0, -lanes * omega));
+    const __m256 step = _mm256_setr_ps(stepScalar.real(), stepScalar.imag(), stepScalar.real(), stepScalar.imag(),
+                                       stepScalar.real(), stepScalar.imag(), stepScalar.real(), stepScalar.imag());
+
+    int vecEnd = numSamples - numSamples % lanes;
+    for (int start = 0; start < vecEnd; start += ncoResetInterval) {
+        int end = std::min(start + ncoResetInterval, vecEnd);
+
+        alignas(32) float init[2 * lanes];
+        initialPhasors<float, lanes>(omega, start, init);
+        __m256 carrLo = _mm256_load_ps(init);
+        __m256 carrHi = _mm256_load_ps(init + 8);
+
+        for (int i = start; i < end; i += lanes) {
+            for (int b = 0; b < numBlocks; ++b) {
+                const float* in = reinterpret_cast<const float*>(signals[b] + i);
+                float* out = reinterpret_cast<float*>(outputs[b] + i);
+                _mm256_storeu_ps(out, complexMul(_mm256_loadu_ps(in), carrLo));
+                _mm256_storeu_ps(out + 8, complexMul(_mm256_loadu_ps(in + 8), carrHi));
+            }
+            carrLo = complexMul(carrLo, step);
+            carrHi = complexMul(carrHi, step);
+        }
+    }
+
+    carrierWipeOffTail(signals, outputs, numBlocks, vecEnd, numSamples, omega);
+}
+
+// GCC 12 reports _mm512_undefined_pd() inside the AVX-512 intrinsics as maybe-uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f")))
+inline __m512d complexMul(__m512d a, __m512d b) {
+    __m512d aRe = _mm512_movedup_pd(a);
+    __m512d aIm = _mm512_permute_pd(a, 0xFF);
+    __m512d bSwap = _mm512_permute_pd(b, 0x55);
+    return _mm512_fmaddsub_pd(aRe, b, _mm512_mul_pd(aIm, bSwap));
+}
+
+__attribute__((target("avx512f")))
+inline __m512 complexMul(__m512 a, __m512 b) {
+    __m512 aRe = _mm512_moveldup_ps(a);
+    __m512 aIm = _mm512_movehdup_ps(a);
+    __m512 bSwap = _mm512_permute_ps(b, 0xB1);
+    return _mm512_fmaddsub_ps(aRe, b, _mm512_mul_ps(aIm, bSwap));
+}
+
+// AVX-512 kernel: 8 samples per iteration (two registers of 4 complex)
+__attribute__((target("avx512f")))
+void carrierWipeOffAvx512(const std::complex<double>* const* signals, std::complex<double>* const* outputs,
+                          int numBlocks, int numSamples, double omega) {
+    constexpr int lanes = 8;
+    const std::complex<double> stepScalar = std::polar(1.0, -lanes * omega);
+    const __m512d step = _mm512_setr_pd(stepScalar.real(), stepScalar.imag(), stepScalar.real(), stepScalar.imag(),
+                                        stepScalar.real(), stepScalar.imag(), stepScalar.real(), stepScalar.imag());
+
+    int vecEnd = numSamples - numSamples % lanes;
+    for (int start = 0; start < vecEnd; start += ncoResetInterval) {
+        int end = std::min(start + ncoResetInterval, vecEnd);
+
+        alignas(64) double init[2 * lanes];
+        initialPhasors<double, lanes>(omega, start, init);
+        __m512d carrLo = _mm512_load_pd(init);
+        __m512d carrHi = _mm512_load_pd(init + 8);
+
+        for (int i = start; i < end; i += lanes) {
+            for (int b = 0; b < numBlocks; ++b) {
+                const double* in = reinterpret_cast<const double*>(signals[b] + i);
+                double* out = reinterpret_cast<double*>(outputs[b] + i);
+                _mm512_storeu_pd(out, complexMul(_mm512_loadu_pd(in), carrLo));
+                _mm512_storeu_pd(out + 8, complexMul(_mm512_loadu_pd(in + 8), carrHi));
+            }
+            carrLo = complexMul(carrLo, step);
+            carrHi = complexMul(carrHi, step);
+        }
+    }
+
+    carrierWipeOffTail(signals, outputs, numBlocks, vecEnd, numSamples, omega);
+}
+
+// AVX-512 single precision kernel: 16 samples per iteration (two registers of 8 complex)
+__attribute__((target("avx512f")))
+void carrierWipeOffAvx512(const std::complex<float>* const* signals, std::complex<float>* const* outputs,
+                          int numBlocks, int numSamples, double omega) {
+    constexpr int lanes = 16;
+    const std::complex<float> stepScalar(std::polar(1.0, -lanes * omega));
+    alignas(64) float stepLanes[16];
+    for (int l = 0; l < 8; ++l) {
+        stepLanes[2 * l] = stepScalar.real();
+        stepLanes[2 * l + 1] = stepScalar.imag();
+    }
+    const __m512 step = _mm512_load_ps(stepLanes);
+
+    int vecEnd = numSamples - numSamples % lanes;
+    for (int start = 0; start < vecEnd; start += ncoResetInterval) {
+        int end = std::min(start + ncoResetInterval, vecEnd);
+
+        alignas(64) float init[2 * lanes];
+        initialPhasors<float, lanes>(omega, start, init);
+        __m512 carrLo = _mm512_load_ps(init);
+        __m512 carrHi = _mm512_load_ps(init + 16);
+
+        for (int i = start; i < end; i += lanes) {
+            for (int b = 0; b < numBlocks; ++b) {
+                const float* in = reinterpret_cast<const float*>(signals[b] + i);
+                float* out = reinterpret_cast<float*>(outputs[b] + i);
+                _mm512_storeu_ps(out, complexMul(_mm512_loadu_ps(in), carrLo));
+                _mm512_storeu_ps(out + 16, complexMul(_mm512_loadu_ps(in + 16), carrHi));
+            }
+            carrLo = complexMul(carrLo, step);
+            carrHi = complexMul(carrHi, step);
+        }
+    }
+
+    carrierWipeOffTail(signals, outputs, numBlocks, vecEnd, numSamples, omega);
+}
+
+#pragma GCC diagnostic pop
+
+#endif // CARRIER_NCO_X86
+
+template <typename T>
+using WipeOffKernel = void (*)(const std::complex<T>* const*, std::complex<T>* const*, int, int, double);
+
+// Pick the widest kernel the CPU supports
+template <typename T>
+WipeOffKernel<T> selectKernel() {
+#ifdef CARRIER_NCO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return carrierWipeOffAvx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return carrierWipeOffAvx2;
+    }
+#endif
+    return carrierWipeOffScalar<T>;
+}
+
+}
+
+void carrierWipeOff(const std::complex<double>* const* signals, std::complex<double>* const* outputs,
+                    int numBlocks, int numSamples, double carrFreq, double samplingFreq) {
+    static const WipeOffKernel<double> kernel = selectKernel<double>();
+    kernel(signals, outputs, numBlocks, numSamples, 2 * M_PI * carrFreq / samplingFreq);
+}
+
+void carrierWipeOff(const std::complex<float>* const* signals, std::complex<float>* const* outputs,
+                    int numBlocks, int numSamples, double carrFreq, double samplingFreq) {
+    static const WipeOffKernel<float> kernel = selectKernel<float>();
+    kernel(signals, outputs, numBlocks, numSamples, 2 * M_PI * carrFreq / samplingFreq);
+}
@@ -0,0 +1,25 @@
+#ifndef CARRIER_NCO_H
+#define CARRIER_NCO_H
+
+#include <complex>
+
+// Carrier wipe-off for the acquisition search. For every block b and sample i:
+//
+//     outputs[b][i] = signals[b][i] * (sin(2*pi*carrFreq*i*ts) + j*cos(2*pi*carrFreq*i*ts))
+//
+// which is the I = sin * signal, Q = cos * signal demodulation written as one interleaved
+// complex output, ready to be used as FFT input. The carrier is a recursive complex phasor,
+// reset to the exact sin/cos value every ncoResetInterval samples, so only a handful of libm
+// calls are made per block. All blocks share the same carrier replica. outputs[b] may be
+// signals[b] (in-place wipe-off).
+void carrierWipeOff(const std::complex<double>* const* signals, std::complex<double>* const* outputs,
+                    int numBlocks, int numSamples, double carrFreq, double samplingFreq);
+
+// Single precision variant (phasors are reset from double precision sin/cos)
+void carrierWipeOff(const std::complex<float>* const* signals, std::complex<float>* const* outputs,
+                    int numBlocks, int numSamples, double carrFreq, double samplingFreq);
+
+// Samples between exact phasor resets (bounds the accumulated rounding error)
+constexpr int ncoResetInterval = 1024;
+
+#endif // CARRIER_NCO_H
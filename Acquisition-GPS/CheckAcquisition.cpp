@@ -0,0 +1,305 @@
+/*
+########################################################################
+# CheckAcquisition.cpp:
+# Detection and equivalence checks of the acquisition engine modes
+#
+#  Project:        sw-rcvr-c++
+#  File:           CheckAcquisition.cpp
+#
+#  Usage: CheckAcquisition [check ...]
+#
+#  Each check searches a synthetic recording with known satellites, down
+#  to the detection threshold, and exits with a failure status on a missed
+#  or misplaced satellite, a false alarm, or a mode that does not detect
+#  like the search it replaces. Without arguments every check runs; ctest
+#  runs them one by one.
+#
+########################################################################
+*/
+
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <functional>
+#include <string>
+#include "SettingsGps.h"
+#include "Acquisition.h"
+#include "AcquisitionHints.h"
+#include "FftPlanCache.h"
+#include "SampleSource.h"
+#include "SignalGenerator.h"
+
+// Known satellites, from well above the detection threshold of the default search down to it
+// (45 dB-Hz), and PRNs of satMask with no signal for the false alarms. The signal carries no
+// navigation data, so a bit edge cannot move a peak to another bin.
+static const std::vector<SyntheticSatellite> checkSatellites = {
+    {3, 1250.0, 1200.0, 50.0}, {11, -2730.0, 20480.0, 47.0}, {19, 405.0, 5555.0, 45.0}, {27, 3310.0, 31000.0, 48.0}};
+static const std::vector<int> checkSatMask = {1, 3, 6, 11, 14, 19, 22, 27, 30};
+constexpr uint64_t checkSeed = 7;
+
+// One recording in both precisions
+struct CheckRecording {
+    std::vector<std::complex<double>> doubleSamples;
+    std::vector<std::complex<float>> singleSamples;
+};
+
+// Failures of one check, printed as they are found
+class CheckReport {
+public:
+    explicit CheckReport(const std::string& name) : name(name) {}
+
+    void fail(const std::string& message) {
+        std::cout << "  " << name << ": " << message << std::endl;
+        ++failures;
+    }
+
+    int failures = 0;
+
+private:
+    std::string name;
+};
+
+static Settings checkSettings() {
+    Settings settings;
+    settings.satMask = checkSatMask;
+    settings.acqDumpResults = false;
+    settings.acqValidatePrecision = false;
+    settings.acqPrintResults = false;
+    return settings;
+}
+
+static CheckRecording makeRecording(const Settings& settings) {
+    // Long enough for every mode: fine frequency estimation needs the longest record
+    Settings resampled = settings;
+    resampled.acqResample = true;
+    Settings fine = settings;
+    fine.acqFineFrequency = true;
+    size_t numSamples = std::max({acquisitionSampleCount(settings), acquisitionSampleCount(resampled),
+                                  acquisitionSampleCount(fine)});
+    std::vector<int8_t> raw(numSamples);
+    SignalGenerator(settings, checkSatellites, checkSeed, 8.0, false).generate(0, numSamples, raw.data());
+
+    CheckRecording recording;
+    recording.doubleSamples.resize(numSamples);
+    recording.singleSamples.resize(numSamples);
+    convertSamples(SampleFormat::Int8Real, raw.data(), numSamples, recording.doubleSamples.data());
+    convertSamples(SampleFormat::Int8Real, raw.data(), numSamples, recording.singleSamples.data());
+    return recording;
+}
+
+// Search in settings.acqPrecision, warm if hints are given
+static AcqResults search(const Settings& settings, const CheckRecording& recording,
+                         const std::vector<AcquisitionHint>& hints = {}) {
+    bool single = settings.acqPrecision == "float";
+    if (hints.empty()) {
+        return single ? searchGpsL1C(settings, recording.singleSamples) : searchGpsL1C(settings, recording.doubleSamples);
+    }
+    return single ? reacquireGpsL1C(settings, recording.singleSamples, hints)
+                  : reacquireGpsL1C(settings, recording.doubleSamples, hints);
+}
+
+// Every known satellite acquired where it was generated (Doppler within 250 Hz per ms of
+// coherent time, adjacent bins being within the noise of each other, and code delay within one
+// sample of the search delay grid plus one input sample), and nothing else
+static void checkTruth(CheckReport& report, const Settings& settings, const AcqResults& acqResults) {
+    int samplesPerCode = std::round(settings.samplingFreq * settings.codeLength / settings.codeFreqBasis);
+    double dopplerTolerance = std::max(settings.acqFreqStepHz, 250.0) / settings.acqCoherentMs;
+    double delayTolerance = settings.samplingFreq / searchSamplingFrequency(settings) + 1.0;
+    for (int PRN : settings.satMask) {
+        const SyntheticSatellite* truth = nullptr;
+        for (const SyntheticSatellite& satellite : checkSatellites) {
+            truth = satellite.PRN == PRN ? &satellite : truth;
+        }
+        std::string prn = "PRN " + std::to_string(PRN);
+        if (!truth) {
+            if (acqResults.acquired[PRN]) {
+                report.fail(prn + " false alarm (metric " + std::to_string(acqResults.peakMetric[PRN]) + ")");
+            }
+            continue;
+        }
+        if (!acqResults.acquired[PRN]) {
+            report.fail(prn + " missed (metric " + std::to_string(acqResults.peakMetric[PRN]) + ")");
+            continue;
+        }
+        double dopplerError = acqResults.carrFreq[PRN] - settings.IF - truth->doppler;
+        double delayError = std::remainder(acqResults.codeDelay[PRN] - truth->codeDelay, samplesPerCode);
+        if (std::abs(dopplerError) > dopplerTolerance || std::abs(delayError) > delayTolerance) {
+            report.fail(prn + " Doppler error " + std::to_string(dopplerError) + " Hz, code delay error " +
+                        std::to_string(delayError) + " samples");
+        }
+    }
+}
+
+// Same decisions as expected; for the PRNs acquired, Doppler within dopplerTolerance, code delay
+// within delayTolerance input samples and peak metric within metricTolerance (relative)
+static void checkSame(CheckReport& report, const Settings& settings, const AcqResults& acqResults,
+                      const AcqResults& expected, double dopplerTolerance, double delayTolerance,
+                      double metricTolerance) {
+    int samplesPerCode = std::round(settings.samplingFreq * settings.codeLength / settings.codeFreqBasis);
+    for (int PRN : settings.satMask) {
+        std::string prn = "PRN " + std::to_string(PRN);
+        if (acqResults.acquired[PRN] != expected.acquired[PRN]) {
+            report.fail(prn + (expected.acquired[PRN] ? " missed" : " false alarm") + " against the expected search");
+            continue;
+        }
+        if (!expected.acquired[PRN]) {
+            continue;
+        }
+        double dopplerError = acqResults.carrFreq[PRN] - expected.carrFreq[PRN];
+        double delayError = std::remainder(acqResults.codeDelay[PRN] - expected.codeDelay[PRN], samplesPerCode);
+        double metricError = std::abs(acqResults.peakMetric[PRN] - expected.peakMetric[PRN]) / expected.peakMetric[PRN];
+        if (std::abs(dopplerError) > dopplerTolerance || std::abs(delayError) > delayTolerance ||
+            metricError > metricTolerance) {
+            report.fail(prn + " differs from the expected search: Doppler " + std::to_string(dopplerError) +
+                        " Hz, code delay " + std::to_string(delayError) + " samples, metric " +
+                        std::to_string(acqResults.peakMetric[PRN]) + " against " +
+                        std::to_string(expected.peakMetric[PRN]));
+        }
+    }
+}
+
+// Hints at the known satellites, off by a fraction of a bin and a few samples as a prediction
+// would be, and at two PRNs with no signal
+static std::vector<AcquisitionHint> checkHints(const Settings& settings) {
+    std::vector<AcquisitionHint> hints;
+    for (const SyntheticSatellite& satellite : checkSatellites) {
+        AcquisitionHint hint;
+        hint.PRN = satellite.PRN;
+        hint.carrFreq = settings.IF + satellite.doppler + 60.0;
+        hint.codeDelay = satellite.codeDelay + 7.0;
+        hints.push_back(hint);
+    }
+    for (int PRN : {6, 22}) {
+        AcquisitionHint hint;
+        hint.PRN = PRN;
+        hint.carrFreq = settings.IF - 1500.0 * (PRN % 3);
+        hint.codeDelay = 1000.0 * PRN;
+        hints.push_back(hint);
+    }
+    return hints;
+}
+
+// Default engine: FFT search at the input rate in the default precision
+static void checkDefault(CheckReport& report, const CheckRecording& recording) {
+    Settings settings = checkSettings();
+    checkTruth(report, settings, search(settings, recording));
+}
+
+// Results do not depend on the thread count or the tile shape
+static void checkThreads(CheckReport& report, const CheckRecording& recording) {
+    Settings settings = checkSettings();
+    settings.acqThreads = 1;
+    AcqResults expected = search(settings, recording);
+    settings.acqThreads = 4;
+    settings.acqTileBins = 3;
+    settings.acqTilePrns = 2;
+    checkSame(report, settings, search(settings, recording), expected, 0.0, 0.0, 0.0);
+}
+
+// Single precision detects like double precision, within acqPrecisionTolerance of the metric
+static void checkPrecision(CheckReport& report, const CheckRecording& recording) {
+    Settings settings = checkSettings();
+    settings.acqPrecision = "double";
+    AcqResults expected = search(settings, recording);
+    settings.acqPrecision = "float";
+    AcqResults acqResults = search(settings, recording);
+    checkTruth(report, settings, acqResults);
+    checkSame(report, settings, acqResults, expected, 0.0, 0.0, settings.acqPrecisionTolerance);
+}
+
+// The circular-shift Doppler search finds the peaks of the per-bin wipe-off within one bin
+static void checkCircularShift(CheckReport& report, const CheckRecording& recording) {
+    Settings settings = checkSettings();
+    settings.acqCircularShiftSearch = false;
+    AcqResults expected = search(settings, recording);
+    settings.acqCircularShiftSearch = true;
+    AcqResults acqResults = search(settings, recording);
+    checkTruth(report, settings, acqResults);
+    checkSame(report, settings, acqResults, expected, settings.acqFreqStepHz / settings.acqCoherentMs, 1.0, 0.2);
+}
+
+// Baseband resampling to a power-of-two FFT size
+static void checkResample(CheckReport& report, const CheckRecording& recording) {
+    Settings settings = checkSettings();
+    settings.acqResample = true;
+    checkTruth(report, settings, search(settings, recording));
+}
+
+// Fine frequency estimation on the acquired satellites
+static void checkFineFrequency(CheckReport& report, const CheckRecording& recording) {
+    Settings settings = checkSettings();
+    settings.acqFineFrequency = true;
+    checkTruth(report, settings, search(settings, recording));
+}
+
+// Warm start with code windows, in the floating-point and bit-packed correlators, detects like
+// the full search
+static void checkWarmStart(CheckReport& report, const CheckRecording& recording) {
+    Settings settings = checkSettings();
+    AcqResults expected = search(settings, recording);
+    std::vector<AcquisitionHint> hints = checkHints(settings);
+    double binStep = settings.acqFreqStepHz / settings.acqCoherentMs;
+    for (int packedBits : {0, 1, 2}) {
+        for (double windowChips : {0.0, 2.0, 10.0}) {
+            settings.acqPackedBits = packedBits;
+            settings.acqWarmCodeWindowChips = windowChips;
+            if (packedBits > 0 && windowChips == 0.0) {
+                continue;
+            }
+            CheckReport windowReport("packed bits " + std::to_string(packedBits) + ", window " +
+                                     std::to_string(static_cast<int>(windowChips)) + " chips");
+            AcqResults acqResults = search(settings, recording, hints);
+            for (const AcquisitionHint& hint : hints) {
+                Settings hinted = settings;
+                hinted.satMask = {hint.PRN};
+                checkSame(windowReport, hinted, acqResults, expected, binStep, 1.0, 0.2);
+            }
+            report.failures += windowReport.failures;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const std::vector<std::pair<std::string, std::function<void(CheckReport&, const CheckRecording&)>>> checks = {
+        {"default", checkDefault},
+        {"threads", checkThreads},
+        {"precision", checkPrecision},
+        {"circularShift", checkCircularShift},
+        {"resample", checkResample},
+        {"fineFrequency", checkFineFrequency},
+        {"warmStart", checkWarmStart}};
+
+    int failures = 0;
+    try {
+        std::vector<std::string> selected(argv + 1, argv + argc);
+        for (const std::string& name : selected) {
+            bool known = false;
+            for (const auto& check : checks) {
+                known |= check.first == name;
+            }
+            if (!known) {
+                throw std::invalid_argument("Unknown check: " + name);
+            }
+        }
+
+        CheckRecording recording = makeRecording(checkSettings());
+        for (const auto& [name, run] : checks) {
+            if (!selected.empty() && std::find(selected.begin(), selected.end(), name) == selected.end()) {
+                continue;
+            }
+            CheckReport report(name);
+            run(report, recording);
+            std::cout << name << ": " << (report.failures == 0 ? "passed" : std::to_string(report.failures) + " failures")
+                      << std::endl;
+            failures += report.failures;
+        }
+        FftPlanCache::instance().release();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
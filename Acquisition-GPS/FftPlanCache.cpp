@@ -0,0 +1,152 @@
+/*
+########################################################################
+# FftPlanCache.cpp:
+# FFTW plan cache and wisdom persistence
+#
+#  Project:        sw-rcvr-c++
+#  File:           FftPlanCache.cpp
+#
+########################################################################
+*/
+
+#include <iostream>
+#include <filesystem>
+#include <stdexcept>
+#include "FftPlanCache.h"
+
+namespace fs = std::filesystem;
+
+std::string fftwWisdomFile(const Settings& settings, FftPlanCache::Precision precision) {
+    std::string name = precision == FftPlanCache::Precision::Double ? "fftw_wisdom.dat" : "fftwf_wisdom.dat";
+    return (fs::path(settings.inputFile).parent_path() / name).string();
+}
+
+FftPlanCache& FftPlanCache::instance() {
+    static FftPlanCache cache;
+    return cache;
+}
+
+void FftPlanCache::configure(const Settings& settings) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (settings.fftPlanningEffort == "estimate") {
+        effortFlags = FFTW_ESTIMATE;
+        return;
+    } else if (settings.fftPlanningEffort == "measure") {
+        effortFlags = FFTW_MEASURE;
+    } else if (settings.fftPlanningEffort == "patient") {
+        effortFlags = FFTW_PATIENT;
+    } else {
+        throw std::invalid_argument("Unknown FFT planning effort: " + settings.fftPlanningEffort);
+    }
+
+    std::string file = fftwWisdomFile(settings, Precision::Double);
+    if (file != wisdomFile) {
+        METRICS_STAGE(FftPlanning);
+        wisdomFile = file;
+        wisdomFileSingle = fftwWisdomFile(settings, Precision::Single);
+        if (fs::exists(wisdomFile)) {
+            fftw_import_wisdom_from_filename(wisdomFile.c_str());
+        }
+        if (fs::exists(wisdomFileSingle)) {
+            fftwf_import_wisdom_from_filename(wisdomFileSingle.c_str());
+        }
+    }
+}
+
+unsigned FftPlanCache::planFlags(int alignment) const {
+    return effortFlags | (alignment != 0 ? FFTW_UNALIGNED : 0);
+}
+
+// Called with the mutex held
+fftw_plan FftPlanCache::createPlan(int size, int howmany, int direction, int alignment) {
+    Entry& entry = plans[Key(size, howmany, direction, Precision::Double, alignment, effortFlags)];
+    if (!entry.planDouble) {
+        METRICS_STAGE(FftPlanning);
+
+        // Planning with FFTW_MEASURE/PATIENT overwrites the arrays, so use scratch buffers
+        size_t length = size_t(size) * howmany + 1;
+        FftwComplexBuffer in = allocComplexBuffer(length);
+        FftwComplexBuffer out = allocComplexBuffer(length);
+        auto* inArr = reinterpret_cast<fftw_complex*>(reinterpret_cast<char*>(in.get()) + alignment);
+        auto* outArr = reinterpret_cast<fftw_complex*>(reinterpret_cast<char*>(out.get()) + alignment);
+        entry.planDouble = howmany == 1
+            ? fftw_plan_dft_1d(size, inArr, outArr, direction, planFlags(alignment))
+            : fftw_plan_many_dft(1, &size, howmany, inArr, nullptr, 1, size, outArr, nullptr, 1, size,
+                                 direction, planFlags(alignment));
+        if (!entry.planDouble) {
+            throw std::runtime_error("FFTW plan creation failed for size " + std::to_string(size));
+        }
+        newWisdom |= effortFlags != FFTW_ESTIMATE;
+    }
+    return entry.planDouble;
+}
+
+fftwf_plan FftPlanCache::createPlanf(int size, int howmany, int direction, int alignment) {
+    Entry& entry = plans[Key(size, howmany, direction, Precision::Single, alignment, effortFlags)];
+    if (!entry.planSingle) {
+        METRICS_STAGE(FftPlanning);
+        size_t length = size_t(size) * howmany + 1;
+        FftwfComplexBuffer in = allocComplexBufferf(length);
+        FftwfComplexBuffer out = allocComplexBufferf(length);
+        auto* inArr = reinterpret_cast<fftwf_complex*>(reinterpret_cast<char*>(in.get()) + alignment);
+        auto* outArr = reinterpret_cast<fftwf_complex*>(reinterpret_cast<char*>(out.get()) + alignment);
+        entry.planSingle = howmany == 1
+            ? fftwf_plan_dft_1d(size, inArr, outArr, direction, planFlags(alignment))
+            : fftwf_plan_many_dft(1, &size, howmany, inArr, nullptr, 1, size, outArr, nullptr, 1, size,
+                                  direction, planFlags(alignment));
+        if (!entry.planSingle) {
+            throw std::runtime_error("FFTW plan creation failed for size " + std::to_string(size));
+        }
+        newWisdom |= effortFlags != FFTW_ESTIMATE;
+    }
+    return entry.planSingle;
+}
+
+fftw_plan FftPlanCache::plan(int size, int direction, int alignment) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return createPlan(size, 1, direction, alignment);
+}
+
+fftwf_plan FftPlanCache::planf(int size, int direction, int alignment) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return createPlanf(size, 1, direction, alignment);
+}
+
+fftw_plan FftPlanCache::planMany(int size, int howmany, int direction) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return createPlan(size, howmany, direction, 0);
+}
+
+fftwf_plan FftPlanCache::planManyf(int size, int howmany, int direction) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return createPlanf(size, howmany, direction, 0);
+}
+
+void FftPlanCache::release() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Plans created with FFTW_ESTIMATE add nothing worth saving
+    if (!wisdomFile.empty() && newWisdom) {
+        METRICS_STAGE(FftPlanning);
+        if (!fftw_export_wisdom_to_filename(wisdomFile.c_str()) ||
+            !fftwf_export_wisdom_to_filename(wisdomFileSingle.c_str())) {
+            std::cerr << "Warning: could not write FFTW wisdom to " << wisdomFile << std::endl;
+        }
+    }
+    newWisdom = false;
+
+    for (auto& [key, entry] : plans) {
+        if (entry.planDouble) {
+            fftw_destroy_plan(entry.planDouble);
+        }
+        if (entry.planSingle) {
+            fftwf_destroy_plan(entry.planSingle);
+        }
+    }
+    plans.clear();
+}
+
+FftPlanCache::~FftPlanCache() {
+    release();
+}
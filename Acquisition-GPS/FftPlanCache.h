@@ -0,0 +1,124 @@
+#ifndef FFT_PLAN_CACHE_H
+#define FFT_PLAN_CACHE_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <fftw3.h>
+#include "SettingsGps.h"
+#include "Metrics.h"
+
+// Deleters for buffers allocated with fftw_malloc / fftwf_malloc
+struct FftwDeleter {
+    void operator()(void* ptr) const { fftw_free(ptr); }
+};
+
+struct FftwfDeleter {
+    void operator()(void* ptr) const { fftwf_free(ptr); }
+};
+
+using FftwComplexBuffer = std::unique_ptr<fftw_complex[], FftwDeleter>;
+using FftwfComplexBuffer = std::unique_ptr<fftwf_complex[], FftwfDeleter>;
+
+// Allocate SIMD-aligned complex buffers released automatically
+inline FftwComplexBuffer allocComplexBuffer(size_t n) {
+    METRICS_COUNT(BytesAllocated, n * sizeof(fftw_complex));
+    return FftwComplexBuffer(fftw_alloc_complex(n));
+}
+
+inline FftwfComplexBuffer allocComplexBufferf(size_t n) {
+    METRICS_COUNT(BytesAllocated, n * sizeof(fftwf_complex));
+    return FftwfComplexBuffer(fftwf_alloc_complex(n));
+}
+
+// Process-wide cache of 1-D complex DFT plans. Plans are created once per
+// (size, batch, direction, precision, alignment, planning effort) and run with the new-array execute
+// interface (fftw_execute_dft) on any buffer with the same alignment.
+class FftPlanCache {
+public:
+    enum class Precision { Double, Single };
+
+    static FftPlanCache& instance();
+
+    // Select the planning effort of the plans returned from now on from
+    // settings.fftPlanningEffort and, for "measure"/"patient", import the wisdom file next to
+    // settings.inputFile. Plans of other efforts stay cached for the searches using them.
+    void configure(const Settings& settings);
+
+    // Cached plans; alignment is the value of fftw_alignment_of on the buffers
+    fftw_plan plan(int size, int direction, int alignment = 0);
+    fftwf_plan planf(int size, int direction, int alignment = 0);
+
+    // Cached plans transforming howmany contiguous arrays of size points in one call
+    // (fftw_plan_many_dft); buffers must be aligned as returned by fftw_malloc
+    fftw_plan planMany(int size, int howmany, int direction);
+    fftwf_plan planManyf(int size, int howmany, int direction);
+
+    // Destroy all plans and export the accumulated wisdom
+    void release();
+
+    ~FftPlanCache();
+
+private:
+    // size, howmany, direction, precision, alignment, planning effort flags
+    using Key = std::tuple<int, int, int, Precision, int, unsigned>;
+
+    struct Entry {
+        fftw_plan planDouble = nullptr;
+        fftwf_plan planSingle = nullptr;
+    };
+
+    FftPlanCache() = default;
+    FftPlanCache(const FftPlanCache&) = delete;
+    FftPlanCache& operator=(const FftPlanCache&) = delete;
+
+    unsigned planFlags(int alignment) const;
+    fftw_plan createPlan(int size, int howmany, int direction, int alignment);
+    fftwf_plan createPlanf(int size, int howmany, int direction, int alignment);
+
+    std::mutex mutex;
+    std::map<Key, Entry> plans;
+    unsigned effortFlags = FFTW_ESTIMATE;
+    std::string wisdomFile;        // Empty until a measured planning effort is configured
+    std::string wisdomFileSingle;
+    bool newWisdom = false;        // Plans measured since the last export
+};
+
+// FFTW interface of each sample precision (fftw_* for double, fftwf_* for float)
+template <typename T>
+struct Fftw;
+
+template <>
+struct Fftw<double> {
+    using Complex = fftw_complex;
+    using Plan = fftw_plan;
+    using Buffer = FftwComplexBuffer;
+
+    static Buffer alloc(size_t n) { return allocComplexBuffer(n); }
+    static Plan plan(int size, int direction) { return FftPlanCache::instance().plan(size, direction); }
+    static Plan planMany(int size, int howmany, int direction) {
+        return FftPlanCache::instance().planMany(size, howmany, direction);
+    }
+    static void execute(Plan plan, Complex* in, Complex* out) { fftw_execute_dft(plan, in, out); }
+};
+
+template <>
+struct Fftw<float> {
+    using Complex = fftwf_complex;
+    using Plan = fftwf_plan;
+    using Buffer = FftwfComplexBuffer;
+
+    static Buffer alloc(size_t n) { return allocComplexBufferf(n); }
+    static Plan plan(int size, int direction) { return FftPlanCache::instance().planf(size, direction); }
+    static Plan planMany(int size, int howmany, int direction) {
+        return FftPlanCache::instance().planManyf(size, howmany, direction);
+    }
+    static void execute(Plan plan, Complex* in, Complex* out) { fftwf_execute_dft(plan, in, out); }
+};
+
+// FFTW wisdom file for settings and precision (stored next to the input file)
+std::string fftwWisdomFile(const Settings& settings, FftPlanCache::Precision precision);
+
+#endif // FFT_PLAN_CACHE_H
@@ -0,0 +1,86 @@
+/*
+########################################################################
+# GenerateSignal.cpp:
+# Write a synthetic GPS L1 C/A IF recording with known satellites
+#
+#  Project:        sw-rcvr-c++
+#  File:           GenerateSignal.cpp
+#
+#  Usage: GenerateSignal [output.dat] [ms] [seed] [PRN:doppler:codeDelay:CN0 ...]
+#
+#  Defaults: Settings::inputFile, 37000 ms, seed 1 and the satellites below.
+#  The truth is also written to output.dat.truth as a visibility list
+#  (PRN, Doppler [Hz], code phase [chips]) usable as acqVisibilityFile.
+#
+########################################################################
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include "SettingsGps.h"
+#include "SignalGenerator.h"
+
+// PRN:doppler:codeDelay:CN0 (Doppler in Hz, code delay in samples, C/N0 in dB-Hz)
+static SyntheticSatellite parseSatellite(const std::string& text) {
+    SyntheticSatellite satellite;
+    std::istringstream fields(text);
+    char colon1, colon2, colon3;
+    if (!(fields >> satellite.PRN >> colon1 >> satellite.doppler >> colon2 >> satellite.codeDelay >> colon3
+                 >> satellite.CN0) || colon1 != ':' || colon2 != ':' || colon3 != ':') {
+        throw std::invalid_argument("Invalid satellite " + text + " (expected PRN:doppler:codeDelay:CN0)");
+    }
+    return satellite;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Settings settings;
+        std::string output = argc > 1 ? argv[1] : settings.inputFile;
+        double ms = argc > 2 ? std::stod(argv[2]) : 37000.0;
+        uint64_t seed = argc > 3 ? std::stoull(argv[3]) : 1;
+
+        std::vector<SyntheticSatellite> satellites;
+        for (int i = 4; i < argc; ++i) {
+            satellites.push_back(parseSatellite(argv[i]));
+        }
+        if (satellites.empty()) {
+            satellites = {{3, 1250.0, 1200.0, 46.0},   {7, -2730.0, 9876.5, 44.0}, {11, 405.0, 20480.0, 42.0},
+                          {16, 3310.0, 31000.0, 45.0}, {19, -880.0, 5555.0, 47.0}, {23, -3950.0, 37000.0, 43.0},
+                          {27, 2100.0, 15000.0, 41.0}, {31, -1510.0, 26000.0, 44.0}};
+        }
+
+        SignalGenerator generator(settings, satellites, seed);
+        size_t numSamples = static_cast<size_t>(ms * 1e-3 * settings.samplingFreq);
+
+        auto start = std::chrono::steady_clock::now();
+        generator.write(output, numSamples);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::ofstream truth(output + ".truth");
+        truth << "# PRN doppler_Hz codePhase_chips  (C/N0 dB-Hz, code delay samples)\n";
+        for (const SyntheticSatellite& satellite : satellites) {
+            truth << satellite.PRN << " " << satellite.doppler << " "
+                  << satellite.codeDelay * settings.codeFreqBasis / settings.samplingFreq << "  # "
+                  << satellite.CN0 << " " << satellite.codeDelay << "\n";
+        }
+        if (!truth) {
+            throw std::runtime_error("Cannot write " + output + ".truth");
+        }
+
+        std::cout << "Wrote " << numSamples << " samples (" << ms << " ms, seed " << seed << ") to " << output
+                  << " in " << seconds << " s, " << seconds * 1e9 / numSamples << " ns/sample" << std::endl;
+        for (const SyntheticSatellite& satellite : satellites) {
+            std::cout << "PRN " << satellite.PRN << ": Doppler " << satellite.doppler << " Hz, code delay "
+                      << satellite.codeDelay << " samples, C/N0 " << satellite.CN0 << " dB-Hz" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+#ifndef GOLDENCODES_H
+#define GOLDENCODES_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+constexpr int caCodeLength = 1023;                      // Chips per C/A code period
+constexpr int caCodeMaxPRN = 37;                        // PRNs with a defined C/A code
+constexpr int caCodeWords = (caCodeLength + 63) / 64;   // 64-bit words per packed code
+
+// G2 delays [chips] for PRN 1..37 (IS-GPS-200, Table 3-Ia); index 0 is unused
+constexpr std::array<int, caCodeMaxPRN + 1> g2Delays = {
+    0, 5, 6, 7, 8, 17, 18, 139, 140, 141, 251,
+    252, 254, 255, 256, 257, 258, 469, 470, 471, 472,
+    473, 474, 509, 512, 513, 514, 515, 516, 859, 860,
+    861, 862, 863, 950, 947, 948, 950};
+
+// C/A codes of every PRN, indexed by PRN number (row 0 is unused).
+// packed holds one bit per chip (chip k in bit k % 64 of word k / 64), set when the chip is -1.
+struct CaCodeTable {
+    std::array<std::array<uint64_t, caCodeWords>, caCodeMaxPRN + 1> packed{};
+    std::array<std::array<int8_t, caCodeLength>, caCodeMaxPRN + 1> chips{};
+    std::array<std::array<float, caCodeLength>, caCodeMaxPRN + 1> chipsFloat{};
+};
+
+// Generate all C/A codes from the G1/G2 shift registers (+1/-1 arithmetic, registers start at -1)
+constexpr CaCodeTable makeCaCodeTable() {
+    std::array<int8_t, caCodeLength> g1{};
+    std::array<int8_t, caCodeLength> g2{};
+    std::array<int8_t, 10> regG1 = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+    std::array<int8_t, 10> regG2 = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+
+    for (int i = 0; i < caCodeLength; ++i) {
+        g1[i] = regG1[9];
+        g2[i] = regG2[9];
+        int8_t saveBitG1 = regG1[2] * regG1[9];  // Feedback 1 + x^3 + x^10
+        int8_t saveBitG2 = regG2[1] * regG2[2] * regG2[5] * regG2[7] * regG2[8] * regG2[9];  // 1 + x^2 + x^3 + x^6 + x^8 + x^9 + x^10
+        for (int j = 9; j > 0; --j) {
+            regG1[j] = regG1[j - 1];
+            regG2[j] = regG2[j - 1];
+        }
+        regG1[0] = saveBitG1;
+        regG2[0] = saveBitG2;
+    }
+
+    CaCodeTable table{};
+    for (int PRN = 1; PRN <= caCodeMaxPRN; ++PRN) {
+        int g2shift = g2Delays[PRN];
+        for (int i = 0; i < caCodeLength; ++i) {
+            int8_t chip = -(g1[i] * g2[(i + caCodeLength - g2shift) % caCodeLength]);
+            table.chips[PRN][i] = chip;
+            table.chipsFloat[PRN][i] = chip;
+            if (chip < 0) {
+                table.packed[PRN][i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+    }
+    return table;
+}
+
+inline constexpr CaCodeTable caCodeTable = makeCaCodeTable();
+
+// Chip index of sample i (0 <= i < samples per code) of a code period sampled at samplingFreq:
+// the chip at the start of the sample, floor(i * fc / fs), clamped to the last chip. The SoftGNSS
+// ceil(ts * (i + 1) / tc) - 1 takes the chip at the end of the sample instead, which leads the
+// signal by one sample and puts the correlation peak one sample late.
+constexpr int caCodeChipIndex(int i, double samplingFreq, double codeFreqBasis = 1.023e6) {
+    int chip = static_cast<int>(i * codeFreqBasis / samplingFreq);
+    return chip < caCodeLength ? chip : caCodeLength - 1;
+}
+
+// Sample i of the C/A code replica of PRN oversampled at samplingFreq
+constexpr int8_t caCodeSample(int PRN, int i, double samplingFreq, double codeFreqBasis = 1.023e6) {
+    return caCodeTable.chips[PRN][caCodeChipIndex(i, samplingFreq, codeFreqBasis)];
+}
+
+// Chip k of PRN from the packed representation
+constexpr int caCodePackedChip(int PRN, int k) {
+    return (caCodeTable.packed[PRN][k / 64] >> (k % 64)) & 1 ? -1 : 1;
+}
+
+// Generate the C/A code (+1/-1 chips) of the given PRN
+std::vector<int> generateGoldCode(int PRN);
+
+#endif // GOLDENCODES_H
@@ -0,0 +1,235 @@
+/*
+########################################################################
+# Metrics.cpp:
+# Per-thread stage timers and counters, JSON and Prometheus export
+#
+#  Project:        sw-rcvr-c++
+#  File:           Metrics.cpp
+#
+########################################################################
+*/
+
+#include "Metrics.h"
+
+#ifdef GNSS_METRICS
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "Goldencodes.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int numStages = static_cast<int>(MetricStage::Count);
+constexpr int numCounters = static_cast<int>(MetricCounter::Count);
+
+// Names in the exported files, in enum order
+const std::array<const char*, numStages> stageNames = {
+    "input_loading", "signal_preparation", "fft_planning", "carrier_wipe_off", "forward_fft",
+    "code_multiply", "inverse_fft", "peak_search", "time_domain_correlation", "fine_frequency",
+    "tracking", "results_output", "plotting"};
+const std::array<const char*, numCounters> counterNames = {
+    "ffts_executed", "bytes_allocated", "samples_loaded", "samples_correlated", "samples_tracked"};
+
+using Counter = std::atomic<uint64_t>;
+
+// Counters of one thread. Only the owning thread writes them, with a relaxed load and store
+// rather than a read-modify-write; the export only reads them.
+struct ThreadMetrics {
+    std::array<Counter, numStages> ticks{};
+    std::array<Counter, numStages> calls{};
+    std::array<Counter, numCounters> counters{};
+    std::array<Counter, caCodeMaxPRN + 1> prnSamples{};
+    std::array<Counter, metricsMaxBins> binSamples{};
+};
+
+void add(Counter& counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// All thread blocks ever created. A block outlives its thread and goes back to a free list, so
+// the workers of successive pools reuse blocks instead of adding new ones.
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance() {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    ThreadMetrics* acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeBlocks.empty()) {
+            ThreadMetrics* block = freeBlocks.back();
+            freeBlocks.pop_back();
+            return block;
+        }
+        blocks.push_back(std::make_unique<ThreadMetrics>());
+        return blocks.back().get();
+    }
+
+    void release(ThreadMetrics* block) {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeBlocks.push_back(block);
+    }
+
+    // Sum of every block into totals
+    void collect(ThreadMetrics& totals) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto sum = [](auto& total, const auto& values) {
+            for (size_t i = 0; i < values.size(); ++i) {
+                add(total[i], values[i].load(std::memory_order_relaxed));
+            }
+        };
+        for (const std::unique_ptr<ThreadMetrics>& block : blocks) {
+            sum(totals.ticks, block->ticks);
+            sum(totals.calls, block->calls);
+            sum(totals.counters, block->counters);
+            sum(totals.prnSamples, block->prnSamples);
+            sum(totals.binSamples, block->binSamples);
+        }
+    }
+
+    // Ticks per second, measured between the creation of the registry and now
+    double ticksPerSecond() const {
+        uint64_t ticks = metricsTicks() - startTicks;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        return seconds > 0.0 ? ticks / seconds : 1.0;
+    }
+
+private:
+    MetricsRegistry() : startTicks(metricsTicks()), startTime(std::chrono::steady_clock::now()) {}
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadMetrics>> blocks;
+    std::vector<ThreadMetrics*> freeBlocks;
+    uint64_t startTicks;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+// Start the tick calibration with the program
+[[maybe_unused]] const bool registryStarted = (MetricsRegistry::instance(), true);
+
+struct ThreadSlot {
+    ThreadMetrics* metrics = MetricsRegistry::instance().acquire();
+    ~ThreadSlot() { MetricsRegistry::instance().release(metrics); }
+};
+
+ThreadMetrics& threadMetrics() {
+    thread_local ThreadSlot slot;
+    return *slot.metrics;
+}
+
+void writeJson(const std::string& path, const ThreadMetrics& totals, double ticksPerSecond) {
+    std::ofstream file(path);
+    file << "{\n  \"stages\": {";
+    for (int stage = 0; stage < numStages; ++stage) {
+        file << (stage ? ",\n" : "\n") << "    \"" << stageNames[stage] << "\": {\"seconds\": "
+             << totals.ticks[stage] / ticksPerSecond << ", \"calls\": " << totals.calls[stage] << "}";
+    }
+    file << "\n  },\n  \"counters\": {";
+    for (int counter = 0; counter < numCounters; ++counter) {
+        file << (counter ? ",\n" : "\n") << "    \"" << counterNames[counter] << "\": " << totals.counters[counter];
+    }
+
+    // Only the PRNs and bins that were searched
+    auto writeMap = [&](const char* name, const auto& values) {
+        file << "\n  },\n  \"" << name << "\": {";
+        bool first = true;
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (values[i] != 0) {
+                file << (first ? "\n" : ",\n") << "    \"" << i << "\": " << values[i];
+                first = false;
+            }
+        }
+    };
+    writeMap("samples_correlated_per_prn", totals.prnSamples);
+    writeMap("samples_correlated_per_bin", totals.binSamples);
+    file << "\n  }\n}\n";
+    if (!file) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+void writePrometheus(const std::string& path, const ThreadMetrics& totals, double ticksPerSecond) {
+    std::ofstream file(path);
+    file << "# HELP gnss_stage_seconds_total Time spent in each stage (inclusive of nested stages)\n"
+         << "# TYPE gnss_stage_seconds_total counter\n";
+    for (int stage = 0; stage < numStages; ++stage) {
+        file << "gnss_stage_seconds_total{stage=\"" << stageNames[stage] << "\"} "
+             << totals.ticks[stage] / ticksPerSecond << "\n";
+    }
+    file << "# HELP gnss_stage_calls_total Times each stage was entered\n"
+         << "# TYPE gnss_stage_calls_total counter\n";
+    for (int stage = 0; stage < numStages; ++stage) {
+        file << "gnss_stage_calls_total{stage=\"" << stageNames[stage] << "\"} " << totals.calls[stage] << "\n";
+    }
+    for (int counter = 0; counter < numCounters; ++counter) {
+        file << "# TYPE gnss_" << counterNames[counter] << "_total counter\n"
+             << "gnss_" << counterNames[counter] << "_total " << totals.counters[counter] << "\n";
+    }
+    file << "# TYPE gnss_prn_samples_correlated_total counter\n";
+    for (size_t PRN = 0; PRN < totals.prnSamples.size(); ++PRN) {
+        if (totals.prnSamples[PRN] != 0) {
+            file << "gnss_prn_samples_correlated_total{prn=\"" << PRN << "\"} " << totals.prnSamples[PRN] << "\n";
+        }
+    }
+    file << "# TYPE gnss_bin_samples_correlated_total counter\n";
+    for (size_t bin = 0; bin < totals.binSamples.size(); ++bin) {
+        if (totals.binSamples[bin] != 0) {
+            file << "gnss_bin_samples_correlated_total{bin=\"" << bin << "\"} " << totals.binSamples[bin] << "\n";
+        }
+    }
+    if (!file) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+}
+
+void metricsAddStage(MetricStage stage, uint64_t ticks) {
+    ThreadMetrics& metrics = threadMetrics();
+    add(metrics.ticks[static_cast<int>(stage)], ticks);
+    add(metrics.calls[static_cast<int>(stage)], 1);
+}
+
+void metricsCount(MetricCounter counter, uint64_t n) {
+    add(threadMetrics().counters[static_cast<int>(counter)], n);
+}
+
+void metricsCountSearch(int PRN, int bin, uint64_t samples) {
+    ThreadMetrics& metrics = threadMetrics();
+    add(metrics.counters[static_cast<int>(MetricCounter::SamplesCorrelated)], samples);
+    if (PRN >= 0 && PRN <= caCodeMaxPRN) {
+        add(metrics.prnSamples[PRN], samples);
+    }
+    add(metrics.binSamples[std::min(std::max(bin, 0), metricsMaxBins - 1)], samples);
+}
+
+void writeMetrics(const std::string& path) {
+    try {
+        fs::path parent = fs::path(path).parent_path();
+        if (!parent.empty()) {
+            fs::create_directories(parent);
+        }
+
+        auto totals = std::make_unique<ThreadMetrics>();
+        MetricsRegistry::instance().collect(*totals);
+        double ticksPerSecond = MetricsRegistry::instance().ticksPerSecond();
+        writeJson(path + ".json", *totals, ticksPerSecond);
+        writePrometheus(path + ".prom", *totals, ticksPerSecond);
+    } catch (const std::exception& e) {
+        std::cerr << "Warning: could not write metrics to " << path << " (" << e.what() << ")" << std::endl;
+    }
+}
+
+#endif // GNSS_METRICS
@@ -0,0 +1,98 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(GNSS_METRICS) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#elif defined(GNSS_METRICS)
+#include <chrono>
+#endif
+
+// Timed stages of a run. Times are inclusive: a stage entered inside another one is also counted
+// in the outer stage.
+enum class MetricStage {
+    InputLoading,           // Conversion of input samples, sample cache build and load
+    SignalPreparation,      // Front-end resampling and copy of the search signal
+    FftPlanning,            // FFTW plan creation, wisdom import and export
+    CarrierWipeOff,
+    ForwardFft,             // Batched block DFTs and coherent sums of 1 ms spectra
+    CodeMultiply,           // Product of the block spectra with the code spectrum
+    InverseFft,
+    PeakSearch,             // Power of the correlations and peak detection
+    TimeDomainCorrelation,  // Warm-start code windows (floating-point or bit-packed)
+    FineFrequency,
+    Tracking,
+    ResultsOutput,          // Result dumps and warm-start results files
+    Plotting,
+    Count
+};
+
+enum class MetricCounter {
+    FftsExecuted,       // 1-D transforms (a batched plan counts one per array)
+    BytesAllocated,     // FFTW buffers, search space surfaces and search signal copies
+    SamplesLoaded,      // Input samples converted to the working precision
+    SamplesCorrelated,  // Search signal samples correlated, summed over PRN and frequency bin
+    SamplesTracked,     // Input samples times tracking channels
+    Count
+};
+
+// Samples correlated per frequency bin are kept for bins 0 .. metricsMaxBins - 1; higher bins add
+// to the last one
+constexpr int metricsMaxBins = 4096;
+
+#ifdef GNSS_METRICS
+
+// Timestamp counter (or steady clock ticks where there is none); converted to seconds at export
+inline uint64_t metricsTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// Add to the block of the calling thread: no lock, each thread only writes its own counters
+void metricsAddStage(MetricStage stage, uint64_t ticks);
+void metricsCount(MetricCounter counter, uint64_t n);
+void metricsCountSearch(int PRN, int bin, uint64_t samples);
+
+// Totals of all threads written to path + ".json" and, in Prometheus text format, path + ".prom".
+// A file that cannot be written is a warning: the metrics never fail the run they describe
+void writeMetrics(const std::string& path);
+
+class ScopedMetricStage {
+public:
+    explicit ScopedMetricStage(MetricStage stage) : stage(stage), start(metricsTicks()) {}
+    ~ScopedMetricStage() { metricsAddStage(stage, metricsTicks() - start); }
+
+    ScopedMetricStage(const ScopedMetricStage&) = delete;
+    ScopedMetricStage& operator=(const ScopedMetricStage&) = delete;
+
+private:
+    MetricStage stage;
+    uint64_t start;
+};
+
+#define METRICS_CONCAT_(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT_(a, b)
+
+// Time the rest of the enclosing scope as stage
+#define METRICS_STAGE(stage) ScopedMetricStage METRICS_CONCAT(metricStage, __LINE__)(MetricStage::stage)
+#define METRICS_COUNT(counter, n) metricsCount(MetricCounter::counter, n)
+#define METRICS_COUNT_SEARCH(PRN, bin, samples) metricsCountSearch(PRN, bin, samples)
+
+#else
+
+// Without GNSS_METRICS the instrumentation compiles to nothing and its arguments are not evaluated
+#define METRICS_STAGE(stage) ((void)0)
+#define METRICS_COUNT(counter, n) ((void)0)
+#define METRICS_COUNT_SEARCH(PRN, bin, samples) ((void)0)
+
+inline void writeMetrics(const std::string&) {}
+
+#endif // GNSS_METRICS
+
+#endif // METRICS_H
@@ -0,0 +1,118 @@
+/*
+########################################################################
+# NpyFile.cpp:
+# Minimal NumPy .npy reader and writer for result dumps
+#
+#  Project:        sw-rcvr-c++
+#  File:           NpyFile.cpp
+#
+########################################################################
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include "NpyFile.h"
+
+constexpr char npyMagic[] = "\x93NUMPY";
+constexpr size_t npyMagicLength = 6;
+constexpr size_t npyHeaderAlignment = 64;
+
+// Header dictionary, padded with spaces so the data starts on a 64-byte boundary
+static std::string npyHeader(const char* descr, const std::vector<size_t>& shape) {
+    std::string shapeText = "(";
+    for (size_t dim : shape) {
+        shapeText += std::to_string(dim) + ", ";
+    }
+    if (shape.size() > 1) {
+        shapeText.erase(shapeText.size() - 1);  // Keep the comma only for 1-D shapes
+        shapeText.back() = ')';
+    } else {
+        shapeText += ")";
+    }
+
+    std::string dict = std::string("{'descr': '") + descr + "', 'fortran_order': False, 'shape': " + shapeText + ", }";
+    size_t prefix = npyMagicLength + 2 + 2;  // Magic, version, header length
+    size_t padding = npyHeaderAlignment - (prefix + dict.size() + 1) % npyHeaderAlignment;
+    return dict + std::string(padding % npyHeaderAlignment, ' ') + "\n";
+}
+
+template <typename T>
+static void writeNpyArray(const std::string& path, const char* descr, const T* data, const std::vector<size_t>& shape) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+
+    std::string header = npyHeader(descr, shape);
+    uint16_t headerLength = static_cast<uint16_t>(header.size());
+    out.write(npyMagic, npyMagicLength);
+    out.put(1);
+    out.put(0);
+    out.put(static_cast<char>(headerLength & 0xff));
+    out.put(static_cast<char>(headerLength >> 8));
+    out.write(header.data(), header.size());
+
+    size_t count = 1;
+    for (size_t dim : shape) {
+        count *= dim;
+    }
+    out.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+void writeNpy(const std::string& path, const float* data, const std::vector<size_t>& shape) {
+    writeNpyArray(path, "<f4", data, shape);
+}
+
+void writeNpy(const std::string& path, const double* data, const std::vector<size_t>& shape) {
+    writeNpyArray(path, "<f8", data, shape);
+}
+
+NpyArray readNpy(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char prefix[npyMagicLength + 4];
+    if (!in || !in.read(prefix, sizeof(prefix)) || std::memcmp(prefix, npyMagic, npyMagicLength) != 0) {
+        throw std::runtime_error(path + " is not a .npy file");
+    }
+    size_t headerLength = static_cast<uint8_t>(prefix[8]) | static_cast<uint8_t>(prefix[9]) << 8;
+    std::string header(headerLength, '\0');
+    in.read(&header[0], headerLength);
+
+    bool isFloat = header.find("'<f4'") != std::string::npos;
+    if (!isFloat && header.find("'<f8'") == std::string::npos) {
+        throw std::runtime_error(path + ": only little endian float32 and float64 arrays are supported");
+    }
+
+    NpyArray array;
+    size_t open = header.find('(', header.find("'shape'"));
+    size_t close = header.find(')', open);
+    std::string shapeText = header.substr(open + 1, close - open - 1);
+    size_t count = 1;
+    for (size_t pos = 0; pos < shapeText.size();) {
+        size_t next = shapeText.find(',', pos);
+        std::string dim = shapeText.substr(pos, next == std::string::npos ? std::string::npos : next - pos);
+        if (dim.find_first_not_of(' ') != std::string::npos) {
+            array.shape.push_back(std::stoul(dim));
+            count *= array.shape.back();
+        }
+        pos = next == std::string::npos ? shapeText.size() : next + 1;
+    }
+
+    array.data.resize(count);
+    if (isFloat) {
+        std::vector<float> values(count);
+        in.read(reinterpret_cast<char*>(values.data()), count * sizeof(float));
+        std::copy(values.begin(), values.end(), array.data.begin());
+    } else {
+        in.read(reinterpret_cast<char*>(array.data.data()), count * sizeof(double));
+    }
+    if (!in) {
+        throw std::runtime_error("Truncated .npy file " + path);
+    }
+    return array;
+}
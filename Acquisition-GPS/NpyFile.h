@@ -0,0 +1,20 @@
+#ifndef NPY_FILE_H
+#define NPY_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Write a C-order array of the given shape as a NumPy .npy file (format 1.0, little endian)
+void writeNpy(const std::string& path, const float* data, const std::vector<size_t>& shape);
+void writeNpy(const std::string& path, const double* data, const std::vector<size_t>& shape);
+
+// Array read back from a .npy file written by writeNpy (float32 or float64), as double
+struct NpyArray {
+    std::vector<size_t> shape;
+    std::vector<double> data;
+};
+
+NpyArray readNpy(const std::string& path);
+
+#endif // NPY_FILE_H
@@ -0,0 +1,117 @@
+/*
+########################################################################
+# PeakDetector.cpp:
+# Streaming correlation peak detection for the acquisition search
+#
+#  Project:        sw-rcvr-c++
+#  File:           PeakDetector.cpp
+#
+########################################################################
+*/
+
+#include <algorithm>
+#include "PeakDetector.h"
+
+template <typename T>
+RowPeakDetector<T>::RowPeakDetector(int samplesPerCode, int samplesPerCodeChip)
+    : samplesPerCode(samplesPerCode), samplesPerCodeChip(std::max(1, samplesPerCodeChip)),
+      numBlocks((samplesPerCode + this->samplesPerCodeChip - 1) / this->samplesPerCodeChip),
+      blockMax(numBlocks), blockSum(numBlocks) {}
+
+template <typename T>
+size_t RowPeakDetector<T>::process(const std::complex<T>* x, int numSums, size_t stride, T* out) {
+    int peakBlock = 0;
+    for (int block = 0; block < numBlocks; ++block) {
+        int begin = block * samplesPerCodeChip;
+        int end = std::min(begin + samplesPerCodeChip, samplesPerCode);
+        T maxValue = 0;
+        T sum = 0;
+        for (int i = begin; i < end; ++i) {
+            T value = std::norm(x[i]);
+            for (int k = 1; k < numSums; ++k) {
+                value += std::norm(x[k * stride + i]);
+            }
+            out[i] = value;
+            maxValue = std::max(maxValue, value);
+            sum += value;
+        }
+        blockMax[block] = maxValue;
+        blockSum[block] = sum;
+        if (maxValue > blockMax[peakBlock]) {
+            peakBlock = block;
+        }
+    }
+
+    // First maximum of the row is the first maximum of the first block holding it
+    int begin = peakBlock * samplesPerCodeChip;
+    int end = std::min(begin + samplesPerCodeChip, samplesPerCode);
+    peak = std::max_element(out + begin, out + end) - out;
+    return peak;
+}
+
+template <typename T>
+SearchRowSummary RowPeakDetector<T>::summarize(const T* out) const {
+    long n = samplesPerCode;
+    long p = static_cast<long>(peak);
+    auto distance = [&](long i) {
+        long d = std::abs(i - p);
+        return std::min(d, n - d);
+    };
+
+    // Samples less than one chip away from the peak (circularly) belong to the peak itself
+    double secondPeak = 0.0;
+    double noiseSum = 0.0;
+    long noiseCount = 0;
+    for (int block = 0; block < numBlocks; ++block) {
+        long begin = static_cast<long>(block) * samplesPerCodeChip;
+        long end = std::min<long>(begin + samplesPerCodeChip, n);
+        long nearest = p >= begin && p < end ? 0 : std::min(distance(begin), distance(end - 1));
+
+        if (nearest >= samplesPerCodeChip) {
+            secondPeak = std::max<double>(secondPeak, blockMax[block]);
+            noiseSum += blockSum[block];
+            noiseCount += end - begin;
+        } else {
+            for (long i = begin; i < end; ++i) {
+                if (distance(i) >= samplesPerCodeChip) {
+                    secondPeak = std::max<double>(secondPeak, out[i]);
+                    noiseSum += out[i];
+                    ++noiseCount;
+                }
+            }
+        }
+    }
+
+    SearchRowSummary summary;
+    summary.peak = out[peak];
+    summary.peakDelay = static_cast<uint32_t>(peak);
+    summary.secondPeak = secondPeak;
+    summary.noiseMean = noiseCount > 0 ? noiseSum / noiseCount : 0.0;
+    return summary;
+}
+
+template class RowPeakDetector<float>;
+template class RowPeakDetector<double>;
+
+template <typename T>
+SearchRowSummary summarizeWindow(const T* values, int numDelays, int firstDelay, int samplesPerCode,
+                                 int samplesPerCodeChip, const SearchRowSummary& reference) {
+    int peak = std::max_element(values, values + numDelays) - values;
+
+    double secondPeak = 0.0;
+    for (int d = 0; d < numDelays; ++d) {
+        if (std::abs(d - peak) >= samplesPerCodeChip) {
+            secondPeak = std::max<double>(secondPeak, values[d]);
+        }
+    }
+
+    SearchRowSummary summary;
+    summary.peak = values[peak];
+    summary.peakDelay = static_cast<uint32_t>((firstDelay + peak) % samplesPerCode);
+    summary.secondPeak = std::max(secondPeak, reference.secondPeak);
+    summary.noiseMean = reference.noiseMean;
+    return summary;
+}
+
+template SearchRowSummary summarizeWindow(const float*, int, int, int, int, const SearchRowSummary&);
+template SearchRowSummary summarizeWindow(const double*, int, int, int, int, const SearchRowSummary&);
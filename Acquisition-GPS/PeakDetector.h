@@ -0,0 +1,40 @@
+#ifndef PEAK_DETECTOR_H
+#define PEAK_DETECTOR_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+#include "SearchSpace.h"
+
+// Streaming peak detection for one (PRN, frequency bin) correlation row. The |correlation|^2
+// loop is split in blocks of one chip and keeps the maximum and sum of every block, so the
+// second peak outside the +-1 chip exclusion window and the noise floor are found from the
+// block statistics plus the few blocks the window cuts, without a second pass over the row.
+template <typename T>
+class RowPeakDetector {
+public:
+    RowPeakDetector(int samplesPerCode, int samplesPerCodeChip);
+
+    // out[i] = sum over k < numSums of |x[k * stride + i]|^2 (non-coherent accumulation of
+    // numSums correlations) for the whole row; returns the index of the first maximum
+    size_t process(const std::complex<T>* x, int numSums, size_t stride, T* out);
+
+    // Peak, second peak and noise floor of the last processed row (out as passed to process)
+    SearchRowSummary summarize(const T* out) const;
+
+private:
+    int samplesPerCode, samplesPerCodeChip, numBlocks;
+    size_t peak = 0;
+    std::vector<T> blockMax, blockSum;
+};
+
+// Summary of a code delay window searched in the time domain: values[d] is the |correlation|^2 at delay (firstDelay + d) mod samplesPerCode. The maximum of a few delays says
+// nothing about the noise maximum over a code period the peak metric is meant to compare with,
+// so the noise floor is that of reference, the summary of a whole code period at one bin of the
+// window, and the second peak the larger of its second peak and that of the window samples at
+// least one chip away from the peak.
+template <typename T>
+SearchRowSummary summarizeWindow(const T* values, int numDelays, int firstDelay, int samplesPerCode,
+                                 int samplesPerCodeChip, const SearchRowSummary& reference);
+
+#endif // PEAK_DETECTOR_H
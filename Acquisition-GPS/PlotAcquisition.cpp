@@ -0,0 +1,120 @@
+/*
+########################################################################
+# PlotAcquisition.cpp:
+# Render the acquisition results dumped by the receiver
+#
+#  Project:        sw-rcvr-c++
+#  File:           PlotAcquisition.cpp
+#
+########################################################################
+*/
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+#include "matplotlibcpp.h"
+#include "SettingsGps.h"
+#include "Acquisition.h"
+#include "NpyFile.h"
+#include "Metrics.h"
+
+namespace plt = matplotlibcpp;
+namespace fs = std::filesystem;
+
+// Bar plot of a per-PRN vector (index 0 is unused). limitY starts the axis at 20 (dB-Hz) when
+// some value is above it; the C/N0 of the PRNs not acquired is 0
+static void plotBar(const std::string& title, const std::vector<double>& data, const std::string& filepath,
+                    bool limitY = false) {
+    if (data.size() < 2) {
+        return;
+    }
+    METRICS_STAGE(Plotting);
+    std::vector<double> x;
+    for (size_t i = 1; i < data.size(); ++i) {
+        x.push_back(static_cast<double>(i));
+    }
+
+    plt::figure();
+    plt::bar(x, std::vector<double>(data.begin() + 1, data.end()));
+    plt::title(title);
+    plt::xlabel("PRN number (no bar - SV is not in the acquisition list)");
+    plt::ylabel(title);
+    plt::grid(true, "--", 0.5);
+
+    double maxValue = *std::max_element(data.begin() + 1, data.end());
+    if (limitY && maxValue > 20) {
+        plt::ylim(20.0, maxValue);
+    }
+
+    plt::save(filepath);
+    plt::close();
+}
+
+// Surface plot of one SEARCH_SPACE_PRN<n>.npy dump; skipped if its shape is not frequencies x
+// delays (a dump left over from a search with another grid)
+static void plotSearchSpace(const std::string& dir, int PRN, const std::vector<double>& frequencies,
+                            const std::vector<double>& delays) {
+    METRICS_STAGE(Plotting);
+    std::string path = dir + "SEARCH_SPACE_PRN" + std::to_string(PRN) + ".npy";
+    NpyArray dump = readNpy(path);
+    if (dump.shape != std::vector<size_t>{frequencies.size(), delays.size()} ||
+        dump.data.size() != frequencies.size() * delays.size()) {
+        std::cerr << "Warning: " << path << " does not match the " << frequencies.size() << " x " << delays.size()
+                  << " search space axes, not plotted" << std::endl;
+        return;
+    }
+    std::vector<std::vector<double>> prnSearchSpace(frequencies.size());
+    for (size_t i = 0; i < frequencies.size(); ++i) {
+        prnSearchSpace[i].assign(dump.data.begin() + i * delays.size(), dump.data.begin() + (i + 1) * delays.size());
+    }
+
+    plt::figure();
+    plt::plot_surface(frequencies, delays, prnSearchSpace, {
+        {"cmap", "coolwarm"},
+        {"antialiased", "False"}
+    });
+
+    plt::title("PRN " + std::to_string(PRN) + " Search Space");
+    plt::xlabel("Doppler Frequency [kHz]");
+    plt::ylabel("Code Delay [chips]");
+    plt::grid(true, "--", 0.5);
+
+    plt::save(dir + "SEARCH_SPACE_PRN" + std::to_string(PRN) + ".png");
+    plt::close();
+}
+
+// Uso: PlotAcquisition [directorio]; por defecto SW-RCVR-C++/ junto al archivo de entrada
+int main(int argc, char* argv[]) {
+    try {
+        std::string dir = argc > 1 ? std::string(argv[1]) + "/" : acquisitionOutputDir(Settings());
+
+        std::vector<double> peakMetric = readNpy(dir + "ACQUISITION_METRIC.npy").data;
+        std::vector<double> SNR = readNpy(dir + "SNR.npy").data;
+
+        // The search space is only dumped when the surface was kept
+        if (fs::exists(dir + "SEARCH_SPACE_FREQUENCIES.npy")) {
+            std::vector<double> frequencies = readNpy(dir + "SEARCH_SPACE_FREQUENCIES.npy").data;
+            std::vector<double> delays = readNpy(dir + "SEARCH_SPACE_DELAYS.npy").data;
+            for (size_t PRN = 1; PRN < peakMetric.size(); ++PRN) {
+                if (fs::exists(dir + "SEARCH_SPACE_PRN" + std::to_string(PRN) + ".npy")) {
+                    plotSearchSpace(dir, PRN, frequencies, delays);
+                }
+            }
+        }
+
+        plotBar("Acquisition Metric", peakMetric, dir + "ACQUISITION_METRIC.png");
+        plotBar("Signal to Noise Ratio [dB-Hz]", SNR, dir + "SNR.png", true);
+
+        Settings settings;
+        if (!settings.metricsFile.empty()) {
+            writeMetrics(settings.metricsFile + ".plot");
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
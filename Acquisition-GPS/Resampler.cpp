@@ -0,0 +1,133 @@
+/*
+########################################################################
+# Resampler.cpp:
+# Decimating front-end for the acquisition search
+#
+#  Project:        sw-rcvr-c++
+#  File:           Resampler.cpp
+#
+########################################################################
+*/
+
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+#include "Resampler.h"
+#include "CarrierNco.h"
+
+PolyphaseResampler::PolyphaseResampler(double inRate, double outRate, int taps, int phases)
+    : inRate(inRate), outRate(outRate), taps(taps), phases(phases), coefficients(size_t(taps) * phases) {
+    // Windowed-sinc prototype with the cutoff at half the lower rate (in cycles per input sample)
+    double cutoff = 0.5 * std::min(inRate, outRate) / inRate;
+    int first = -taps / 2 + 1;
+
+    for (int phase = 0; phase < phases; ++phase) {
+        double frac = static_cast<double>(phase) / phases;
+        double* h = &coefficients[size_t(phase) * taps];
+        double gain = 0.0;
+
+        for (int k = 0; k < taps; ++k) {
+            double t = first + k - frac;  // Distance to the output instant [input samples]
+            double x = 2 * cutoff * t;
+            double sinc = x == 0.0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+            double w = (t + taps / 2.0) / taps;  // Blackman window over [0, 1]
+            double window = w <= 0.0 || w >= 1.0 ? 0.0
+                          : 0.42 - 0.5 * std::cos(2 * M_PI * w) + 0.08 * std::cos(4 * M_PI * w);
+            h[k] = sinc * window;
+            gain += h[k];
+        }
+
+        // Unit DC gain on every phase
+        for (int k = 0; k < taps; ++k) {
+            h[k] /= gain;
+        }
+    }
+
+    coefficientsFloat.assign(coefficients.begin(), coefficients.end());
+}
+
+// Coefficients in the precision of the samples being filtered
+template <typename T>
+static const T* phaseCoefficients(const std::vector<double>& coefficients, const std::vector<float>& coefficientsFloat,
+                                  size_t offset) {
+    if constexpr (std::is_same_v<T, float>) {
+        return coefficientsFloat.data() + offset;
+    } else {
+        return coefficients.data() + offset;
+    }
+}
+
+template <typename T>
+void PolyphaseResampler::process(const std::complex<T>* in, size_t inCount, std::complex<T>* out, size_t outCount) const {
+    process(in, 0, inCount, out, 0, outCount);
+}
+
+template <typename T>
+void PolyphaseResampler::process(const std::complex<T>* in, size_t inFirst, size_t inCount,
+                                 std::complex<T>* out, size_t outFirst, size_t outCount) const {
+    double step = inRate / outRate;
+    long first = -taps / 2 + 1;
+
+    for (size_t n = 0; n < outCount; ++n) {
+        double position = (outFirst + n) * step;
+        long index = static_cast<long>(std::floor(position));
+        int phase = static_cast<int>(std::lround((position - index) * phases));
+        if (phase == phases) {
+            phase = 0;
+            ++index;
+        }
+
+        const T* h = phaseCoefficients<T>(coefficients, coefficientsFloat, size_t(phase) * taps);
+        long start = index + first - static_cast<long>(inFirst);
+        int kBegin = static_cast<int>(std::max(0L, -start));
+        int kEnd = static_cast<int>(std::min<long>(taps, static_cast<long>(inCount) - start));
+
+        std::complex<T> acc = 0;
+        for (int k = kBegin; k < kEnd; ++k) {
+            acc += in[start + k] * h[k];
+        }
+        out[n] = acc;
+    }
+}
+
+template void PolyphaseResampler::process(const std::complex<float>*, size_t, std::complex<float>*, size_t) const;
+template void PolyphaseResampler::process(const std::complex<double>*, size_t, std::complex<double>*, size_t) const;
+template void PolyphaseResampler::process(const std::complex<float>*, size_t, size_t,
+                                          std::complex<float>*, size_t, size_t) const;
+template void PolyphaseResampler::process(const std::complex<double>*, size_t, size_t,
+                                          std::complex<double>*, size_t, size_t) const;
+
+void PolyphaseResampler::inputRange(size_t outFirst, size_t outCount, size_t& first, size_t& last) const {
+    double step = inRate / outRate;
+    long begin = static_cast<long>(std::floor(outFirst * step)) - taps / 2 + 1;
+    first = static_cast<size_t>(std::max(0L, begin));
+    // One extra sample covers the phase rounding up to the next input sample
+    last = static_cast<size_t>(std::floor((outFirst + outCount - 1) * step)) + taps / 2 + 2;
+}
+
+template <typename T, typename In>
+std::vector<std::complex<T>> basebandResample(const std::vector<std::complex<In>>& inputSignal, size_t numOut,
+                                              double mixFreq, double inRate, double outRate, int taps) {
+    PolyphaseResampler resampler(inRate, outRate, taps);
+
+    // Only convert and mix the input the filter will actually read (mixed in place)
+    size_t inCount = std::min(inputSignal.size(),
+                              static_cast<size_t>(std::ceil(numOut * inRate / outRate)) + resampler.halfLength());
+    std::vector<std::complex<T>> mixed(inputSignal.begin(), inputSignal.begin() + inCount);
+    const std::complex<T>* signals[1] = {mixed.data()};
+    std::complex<T>* outputs[1] = {mixed.data()};
+    carrierWipeOff(signals, outputs, 1, inCount, mixFreq, inRate);
+
+    std::vector<std::complex<T>> baseband(numOut);
+    resampler.process(mixed.data(), inCount, baseband.data(), numOut);
+    return baseband;
+}
+
+template std::vector<std::complex<float>> basebandResample(const std::vector<std::complex<float>>&, size_t,
+                                                           double, double, double, int);
+template std::vector<std::complex<float>> basebandResample(const std::vector<std::complex<double>>&, size_t,
+                                                           double, double, double, int);
+template std::vector<std::complex<double>> basebandResample(const std::vector<std::complex<float>>&, size_t,
+                                                            double, double, double, int);
+template std::vector<std::complex<double>> basebandResample(const std::vector<std::complex<double>>&, size_t,
+                                                            double, double, double, int);
@@ -0,0 +1,48 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// Low-pass polyphase FIR resampler for complex baseband signals. Output sample n is centred on
+// input time n * inRate / outRate (no group delay), interpolated with the nearest of `phases`
+// sub-sample filter phases, so any rate ratio is supported.
+class PolyphaseResampler {
+public:
+    // taps: filter length in input samples; cutoff at half the lower of the two rates
+    PolyphaseResampler(double inRate, double outRate, int taps, int phases = 256);
+
+    // Resample in[0, inCount) into out[0, outCount); input outside the range is taken as zero.
+    // Implemented for float and double samples.
+    template <typename T>
+    void process(const std::complex<T>* in, size_t inCount, std::complex<T>* out, size_t outCount) const;
+
+    // Streaming form: in holds input samples [inFirst, inFirst + inCount) and out receives output
+    // samples [outFirst, outFirst + outCount); input outside the held range is taken as zero.
+    template <typename T>
+    void process(const std::complex<T>* in, size_t inFirst, size_t inCount,
+                 std::complex<T>* out, size_t outFirst, size_t outCount) const;
+
+    // Input samples [first, last) needed for output samples [outFirst, outFirst + outCount)
+    void inputRange(size_t outFirst, size_t outCount, size_t& first, size_t& last) const;
+
+    // Input samples needed to the right of the last output's centre
+    int halfLength() const { return taps / 2; }
+
+private:
+    double inRate, outRate;
+    int taps, phases;
+    std::vector<double> coefficients;  // [phase][tap]
+    std::vector<float> coefficientsFloat;
+};
+
+// Mix the input down by mixFreq and resample it to outRate, producing numOut samples in
+// precision T. The mixer is the acquisition carrier replica, so the output carries a constant
+// 90 deg phase offset, which is irrelevant for the correlation magnitude.
+// Implemented for T and In in {float, double}.
+template <typename T, typename In>
+std::vector<std::complex<T>> basebandResample(const std::vector<std::complex<In>>& inputSignal, size_t numOut,
+                                              double mixFreq, double inRate, double outRate, int taps);
+
+#endif // RESAMPLER_H
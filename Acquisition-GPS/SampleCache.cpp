@@ -0,0 +1,244 @@
+/*
+########################################################################
+# SampleCache.cpp:
+# Versioned memory-mapped cache of the preprocessed search signal
+#
+#  Project:        sw-rcvr-c++
+#  File:           SampleCache.cpp
+#
+########################################################################
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SampleCache.h"
+#include "Resampler.h"
+#include "CarrierNco.h"
+#include "Metrics.h"
+
+namespace fs = std::filesystem;
+
+constexpr char cacheMagic[8] = {'G', 'N', 'S', 'S', 'C', 'A', 'C', 'H'};
+constexpr uint32_t cacheVersion = 1;
+constexpr uint32_t cacheAlignment = 64;
+constexpr size_t cacheChunkSamples = size_t(1) << 16;  // Output samples written per streaming step
+
+static CacheSampleType cacheSampleType(const Settings& settings) {
+    return settings.acqPrecision == "float" ? CacheSampleType::ComplexFloat32 : CacheSampleType::ComplexFloat64;
+}
+
+// Search signal samples kept in the cache
+static size_t cacheSampleCount(const Settings& settings) {
+    size_t samplesPerCode = static_cast<size_t>(
+        std::round(searchSamplingFrequency(settings) * settings.codeLength / settings.codeFreqBasis));
+    return std::max(searchSignalSampleCount(settings), size_t(std::max(settings.sampleCacheMs, 0)) * samplesPerCode);
+}
+
+uint64_t sampleCacheHash(const Settings& settings) {
+    std::error_code error;
+    fs::path input = fs::weakly_canonical(settings.inputFile, error);
+    uintmax_t inputBytes = fs::file_size(settings.inputFile, error);
+    auto modified = fs::last_write_time(settings.inputFile, error).time_since_epoch().count();
+
+    // Frequencies in hexadecimal so the key is exact
+    std::ostringstream key;
+    key << std::hexfloat << input.string() << '|' << inputBytes << '|' << modified << '|' << settings.dataType
+        << '|' << settings.samplingFreq << '|' << settings.IF << '|' << settings.codeFreqBasis << '|'
+        << settings.codeLength << '|' << settings.acqResample << '|' << searchSamplingFrequency(settings) << '|'
+        << settings.acqResampleTaps << '|' << static_cast<uint32_t>(cacheSampleType(settings));
+
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : key.str()) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Write numSamples search signal samples in precision T, one chunk at a time
+template <typename T>
+static void writeSamples(std::ofstream& out, const Settings& settings, const SampleSource& source, size_t numSamples) {
+    std::vector<std::complex<T>> chunk;
+    if (!settings.acqResample) {
+        for (size_t first = 0; first < numSamples; first += cacheChunkSamples) {
+            size_t count = std::min(cacheChunkSamples, numSamples - first);
+            chunk.resize(count);
+            source.read<T>(first, count, chunk.data());
+            out.write(reinterpret_cast<const char*>(chunk.data()), count * sizeof(std::complex<T>));
+        }
+        return;
+    }
+
+    // Same mixer and filter as basebandResample(), applied to the input span each output chunk reads
+    PolyphaseResampler resampler(settings.samplingFreq, searchSamplingFrequency(settings), settings.acqResampleTaps);
+    std::vector<std::complex<T>> input;
+    for (size_t outFirst = 0; outFirst < numSamples; outFirst += cacheChunkSamples) {
+        size_t count = std::min(cacheChunkSamples, numSamples - outFirst);
+        size_t inFirst, inLast;
+        resampler.inputRange(outFirst, count, inFirst, inLast);
+        input.resize(inLast - inFirst);
+        source.read<T>(inFirst, input.size(), input.data());
+
+        // The wipe-off restarts its phase at the chunk start: rotate the chunk to the phase the
+        // mixer has at input sample inFirst
+        const std::complex<T>* signals[1] = {input.data()};
+        std::complex<T>* outputs[1] = {input.data()};
+        carrierWipeOff(signals, outputs, 1, static_cast<int>(input.size()), settings.IF, settings.samplingFreq);
+        double cycles = std::fmod(settings.IF / settings.samplingFreq * static_cast<double>(inFirst), 1.0);
+        std::complex<T> rotation = std::polar<T>(1, static_cast<T>(-2 * M_PI * cycles));
+        for (std::complex<T>& sample : input) {
+            sample *= rotation;
+        }
+
+        chunk.resize(count);
+        resampler.process(input.data(), inFirst, input.size(), chunk.data(), outFirst, count);
+        out.write(reinterpret_cast<const char*>(chunk.data()), count * sizeof(std::complex<T>));
+    }
+}
+
+// Build the cache in a temporary file and rename it over path, so a reader never maps a
+// partially written cache
+static void buildCache(const std::string& path, const Settings& settings, const SampleSource& source,
+                       uint64_t hash, CacheSampleType type, size_t numSamples) {
+    METRICS_STAGE(SignalPreparation);
+    std::string tempPath = path + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot write sample cache " + tempPath);
+    }
+
+    SampleCacheHeader header = {};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.sampleType = static_cast<uint32_t>(type);
+    header.settingsHash = hash;
+    header.numSamples = numSamples;
+    header.dataOffset = sizeof(SampleCacheHeader);
+    header.alignment = cacheAlignment;
+    header.samplingFreq = searchSamplingFrequency(settings);
+    header.carrierOffset = searchCarrierOffset(settings);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (type == CacheSampleType::ComplexFloat32) {
+        writeSamples<float>(out, settings, source, numSamples);
+    } else {
+        writeSamples<double>(out, settings, source, numSamples);
+    }
+    out.close();
+    if (!out) {
+        std::remove(tempPath.c_str());
+        throw std::runtime_error("Cannot write sample cache " + tempPath);
+    }
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        throw std::runtime_error("Cannot rename sample cache to " + path + ": " + std::strerror(errno));
+    }
+}
+
+SampleCache::SampleCache(const Settings& settings, const SampleSource& source) {
+    const std::string& path = settings.sampleCacheFile;
+    if (path.empty()) {
+        throw std::invalid_argument("No sample cache file configured");
+    }
+
+    uint64_t hash = sampleCacheHash(settings);
+    CacheSampleType type = cacheSampleType(settings);
+    size_t numSamples = cacheSampleCount(settings);
+    if (!map(path, hash, type, numSamples)) {
+        buildCache(path, settings, source, hash, type, numSamples);
+        wasRebuilt = true;
+        if (!map(path, hash, type, numSamples)) {
+            throw std::runtime_error("Sample cache " + path + " is invalid after being rebuilt");
+        }
+    }
+}
+
+SampleCache::~SampleCache() {
+    unmap();
+}
+
+// Map the cache and check its header; false (and nothing mapped) if it is missing or stale
+bool SampleCache::map(const std::string& path, uint64_t hash, CacheSampleType type, size_t numSamples) {
+    METRICS_STAGE(InputLoading);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return false;
+        }
+        throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot stat " + path + ": " + std::strerror(errno));
+    }
+    if (static_cast<size_t>(info.st_size) < sizeof(SampleCacheHeader)) {
+        close(fd);
+        return false;
+    }
+
+    void* ptr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping keeps the file referenced
+    if (ptr == MAP_FAILED) {
+        throw std::runtime_error("Cannot map " + path + ": " + std::strerror(errno));
+    }
+    mapping = ptr;
+    mappedBytes = info.st_size;
+
+    const SampleCacheHeader& cached = header();
+    size_t sampleSize = type == CacheSampleType::ComplexFloat32 ? sizeof(std::complex<float>)
+                                                                : sizeof(std::complex<double>);
+    bool valid = std::memcmp(cached.magic, cacheMagic, sizeof(cacheMagic)) == 0 && cached.version == cacheVersion
+              && cached.sampleType == static_cast<uint32_t>(type) && cached.settingsHash == hash
+              && cached.numSamples >= numSamples && cached.alignment == cacheAlignment
+              && cached.dataOffset % cacheAlignment == 0
+              && cached.dataOffset + cached.numSamples * sampleSize <= mappedBytes;
+    if (!valid) {
+        unmap();
+        return false;
+    }
+    madvise(ptr, mappedBytes, MADV_WILLNEED);
+    return true;
+}
+
+void SampleCache::unmap() {
+    if (mapping) {
+        munmap(const_cast<void*>(mapping), mappedBytes);
+        mapping = nullptr;
+        mappedBytes = 0;
+    }
+}
+
+template <typename T>
+SearchSignal<T> SampleCache::signal() const {
+    const SampleCacheHeader& cached = header();
+    CacheSampleType type = std::is_same_v<T, float> ? CacheSampleType::ComplexFloat32 : CacheSampleType::ComplexFloat64;
+    if (cached.sampleType != static_cast<uint32_t>(type)) {
+        throw std::logic_error("Sample cache precision does not match the requested one");
+    }
+
+    SearchSignal<T> view;
+    view.samples = reinterpret_cast<const std::complex<T>*>(static_cast<const char*>(mapping) + cached.dataOffset);
+    view.numSamples = cached.numSamples;
+    view.samplingFreq = cached.samplingFreq;
+    view.carrierOffset = cached.carrierOffset;
+    return view;
+}
+
+template SearchSignal<float> SampleCache::signal() const;
+template SearchSignal<double> SampleCache::signal() const;
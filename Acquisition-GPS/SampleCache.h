@@ -0,0 +1,66 @@
+#ifndef SAMPLE_CACHE_H
+#define SAMPLE_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "SettingsGps.h"
+#include "SampleSource.h"
+#include "Acquisition.h"
+
+// Sample type of a cache file
+enum class CacheSampleType : uint32_t {
+    ComplexFloat32 = 1,
+    ComplexFloat64 = 2
+};
+
+// On-disk header of a sample cache, followed by numSamples complex samples at dataOffset.
+// Native byte order; the samples are used in place from the mapping, so nothing is parsed.
+struct SampleCacheHeader {
+    char magic[8];             // "GNSSCACH"
+    uint32_t version;
+    uint32_t sampleType;       // CacheSampleType
+    uint64_t settingsHash;     // sampleCacheHash() of the settings and input the cache was built from
+    uint64_t numSamples;
+    uint64_t dataOffset;       // Bytes from the start of the file, a multiple of alignment
+    uint32_t alignment;        // [bytes]
+    uint32_t reserved;
+    double samplingFreq;       // SearchSignal::samplingFreq [Hz]
+    double carrierOffset;      // SearchSignal::carrierOffset [Hz]
+};
+static_assert(sizeof(SampleCacheHeader) == 64, "Sample cache header must stay 64 bytes");
+
+// Hash of everything the cached samples depend on: the input file (path, size and modification
+// time), its format, the acquisition front-end and the cache precision
+uint64_t sampleCacheHash(const Settings& settings);
+
+// Preprocessed search signal cached on disk: the input after the optional resampling front-end,
+// converted to the search precision. The cache is written in one streaming pass (the input is
+// never held in memory as a whole) and memory-mapped read-only afterwards. A cache whose header
+// does not match the current settings and input is rebuilt, so it is never stale.
+class SampleCache {
+public:
+    // Map Settings::sampleCacheFile, rebuilding it from source first if it is missing or stale
+    SampleCache(const Settings& settings, const SampleSource& source);
+    ~SampleCache();
+
+    SampleCache(const SampleCache&) = delete;
+    SampleCache& operator=(const SampleCache&) = delete;
+
+    bool rebuilt() const { return wasRebuilt; }  // The file was (re)written by this constructor
+    const SampleCacheHeader& header() const { return *static_cast<const SampleCacheHeader*>(mapping); }
+
+    // Zero-copy view of the cached samples; T must match the cache precision
+    template <typename T>
+    SearchSignal<T> signal() const;
+
+private:
+    bool map(const std::string& path, uint64_t hash, CacheSampleType type, size_t numSamples);
+    void unmap();
+
+    const void* mapping = nullptr;
+    size_t mappedBytes = 0;
+    bool wasRebuilt = false;
+};
+
+#endif // SAMPLE_CACHE_H
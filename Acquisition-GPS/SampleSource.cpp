@@ -0,0 +1,153 @@
+/*
+########################################################################
+# SampleSource.cpp:
+# Memory-mapped raw IF sample reader
+#
+#  Project:        sw-rcvr-c++
+#  File:           SampleSource.cpp
+#
+########################################################################
+*/
+
+#include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SampleSource.h"
+#include "Metrics.h"
+
+SampleFormat parseSampleFormat(const std::string& dataType) {
+    if (dataType == "int8") {
+        return SampleFormat::Int8Real;
+    } else if (dataType == "int8iq") {
+        return SampleFormat::Int8IQ;
+    } else if (dataType == "int16iq") {
+        return SampleFormat::Int16IQ;
+    }
+    throw std::invalid_argument("Unknown sample data type: " + dataType);
+}
+
+size_t sampleBytes(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::Int8Real: return 1;
+        case SampleFormat::Int8IQ: return 2;
+        case SampleFormat::Int16IQ: return 4;
+    }
+    return 1;
+}
+
+SampleSource::SampleSource(const std::string& path, SampleFormat format) : sampleFormat(format) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot stat " + path + ": " + std::strerror(errno));
+    }
+
+    mappedBytes = info.st_size;
+    numSamples = mappedBytes / sampleBytes(format);
+    if (mappedBytes > 0) {
+        void* ptr = mmap(nullptr, mappedBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Cannot map " + path + ": " + std::strerror(errno));
+        }
+        mapping = ptr;
+    }
+    close(fd);  // The mapping keeps the file referenced
+}
+
+SampleSource::~SampleSource() {
+    if (mapping) {
+        munmap(const_cast<void*>(mapping), mappedBytes);
+    }
+}
+
+const int8_t* SampleSource::int8Real() const {
+    if (sampleFormat != SampleFormat::Int8Real) {
+        throw std::logic_error("Recording is not int8 real");
+    }
+    return static_cast<const int8_t*>(mapping);
+}
+
+const int8_t* SampleSource::int8IQ() const {
+    if (sampleFormat != SampleFormat::Int8IQ) {
+        throw std::logic_error("Recording is not int8 I/Q");
+    }
+    return static_cast<const int8_t*>(mapping);
+}
+
+const int16_t* SampleSource::int16IQ() const {
+    if (sampleFormat != SampleFormat::Int16IQ) {
+        throw std::logic_error("Recording is not int16 I/Q");
+    }
+    return static_cast<const int16_t*>(mapping);
+}
+
+template <typename T>
+void SampleSource::read(size_t first, size_t count, std::complex<T>* out) const {
+    METRICS_STAGE(InputLoading);
+    METRICS_COUNT(SamplesLoaded, count);
+    size_t available = first < numSamples ? std::min(count, numSamples - first) : 0;
+
+    // Let the kernel prefetch only the pages about to be converted
+    if (available > 0) {
+        size_t page = sysconf(_SC_PAGESIZE);
+        size_t begin = first * sampleBytes(sampleFormat) / page * page;
+        size_t end = (first + available) * sampleBytes(sampleFormat);
+        madvise(static_cast<char*>(const_cast<void*>(mapping)) + begin, end - begin, MADV_WILLNEED);
+    }
+
+    convertSamples(sampleFormat, static_cast<const char*>(mapping) + first * sampleBytes(sampleFormat), available, out);
+    std::fill(out + available, out + count, std::complex<T>(0, 0));
+}
+
+template <typename T>
+void convertSamples(SampleFormat format, const void* raw, size_t count, std::complex<T>* out) {
+    switch (format) {
+        case SampleFormat::Int8Real: {
+            const int8_t* samples = static_cast<const int8_t*>(raw);
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = std::complex<T>(samples[i], 0);
+            }
+            break;
+        }
+        case SampleFormat::Int8IQ: {
+            const int8_t* samples = static_cast<const int8_t*>(raw);
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = std::complex<T>(samples[2 * i], samples[2 * i + 1]);
+            }
+            break;
+        }
+        case SampleFormat::Int16IQ: {
+            const int16_t* samples = static_cast<const int16_t*>(raw);
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = std::complex<T>(samples[2 * i], samples[2 * i + 1]);
+            }
+            break;
+        }
+    }
+}
+
+template void convertSamples(SampleFormat, const void*, size_t, std::complex<float>*);
+template void convertSamples(SampleFormat, const void*, size_t, std::complex<double>*);
+
+template <typename T>
+std::vector<std::complex<T>> SampleSource::read(size_t first, size_t count) const {
+    std::vector<std::complex<T>> samples(count);
+    read(first, count, samples.data());
+    return samples;
+}
+
+template void SampleSource::read(size_t, size_t, std::complex<float>*) const;
+template void SampleSource::read(size_t, size_t, std::complex<double>*) const;
+template std::vector<std::complex<float>> SampleSource::read<float>(size_t, size_t) const;
+template std::vector<std::complex<double>> SampleSource::read<double>(size_t, size_t) const;
@@ -0,0 +1,59 @@
+#ifndef SAMPLE_SOURCE_H
+#define SAMPLE_SOURCE_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// On-disk sample formats of raw IF recordings
+enum class SampleFormat {
+    Int8Real,   // One int8 per sample
+    Int8IQ,     // Interleaved int8 I, Q
+    Int16IQ     // Interleaved int16 I, Q (native byte order)
+};
+
+// Parse Settings::dataType ("int8", "int8iq", "int16iq")
+SampleFormat parseSampleFormat(const std::string& dataType);
+
+// Bytes per sample of each format
+size_t sampleBytes(SampleFormat format);
+
+// Convert count raw samples to the working precision (float or double)
+template <typename T>
+void convertSamples(SampleFormat format, const void* raw, size_t count, std::complex<T>* out);
+
+// Raw recording mapped read-only into memory. Nothing is read or converted up front: the typed
+// views point straight into the mapping and read() converts only the requested samples.
+class SampleSource {
+public:
+    SampleSource(const std::string& path, SampleFormat format);
+    ~SampleSource();
+
+    SampleSource(const SampleSource&) = delete;
+    SampleSource& operator=(const SampleSource&) = delete;
+
+    SampleFormat format() const { return sampleFormat; }
+    size_t size() const { return numSamples; }  // Number of (complex or real) samples
+
+    // Zero-copy views of the mapping; only valid for the matching format
+    const int8_t* int8Real() const;
+    const int8_t* int8IQ() const;    // 2 * size() values
+    const int16_t* int16IQ() const;  // 2 * size() values
+
+    // Convert samples [first, first + count) to the working precision (float or double).
+    // Samples past the end of the recording are zero.
+    template <typename T = double>
+    void read(size_t first, size_t count, std::complex<T>* out) const;
+    template <typename T = double>
+    std::vector<std::complex<T>> read(size_t first, size_t count) const;
+
+private:
+    const void* mapping = nullptr;
+    size_t mappedBytes = 0;
+    size_t numSamples = 0;
+    SampleFormat sampleFormat;
+};
+
+#endif // SAMPLE_SOURCE_H
@@ -0,0 +1,156 @@
+/*
+########################################################################
+# SearchSpace.cpp:
+# Flat storage of the acquisition search space
+#
+#  Project:        sw-rcvr-c++
+#  File:           SearchSpace.cpp
+#
+########################################################################
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+#include <stdexcept>
+#include "SearchSpace.h"
+#include "Metrics.h"
+
+constexpr size_t searchSpaceAlignment = 64;  // Bytes (one cache line, one AVX-512 vector)
+
+SearchSpaceStorage parseSearchSpaceStorage(const std::string& storage) {
+    if (storage == "float") {
+        return SearchSpaceStorage::Float32;
+    } else if (storage == "uint16") {
+        return SearchSpaceStorage::UInt16;
+    } else if (storage == "summary") {
+        return SearchSpaceStorage::Summary;
+    }
+    throw std::invalid_argument("Unknown search space storage: " + storage);
+}
+
+void SearchSpace::initialize(SearchSpaceStorage storage, const std::vector<int>& prns, size_t nFrqBins,
+                             size_t samplesPerCode) {
+    storageMode = storage;
+    this->nFrqBins = nFrqBins;
+    numDelays = samplesPerCode;
+
+    slots.assign(*std::max_element(prns.begin(), prns.end()) + 1, -1);
+    for (size_t i = 0; i < prns.size(); ++i) {
+        slots[prns[i]] = static_cast<int>(i);
+    }
+    size_t numRows = prns.size() * nFrqBins;
+    summaries.assign(numRows, SearchRowSummary());
+
+    size_t elementBytes = storage == SearchSpaceStorage::UInt16 ? sizeof(uint16_t) : sizeof(float);
+    size_t rowBytes = (samplesPerCode * elementBytes + searchSpaceAlignment - 1) / searchSpaceAlignment
+                    * searchSpaceAlignment;
+    rowStride = rowBytes / elementBytes;
+    surfaceBytes = hasSurface() ? numRows * rowBytes : 0;
+    rowScales.assign(storage == SearchSpaceStorage::UInt16 ? numRows : 0, 0.0f);
+
+    data.reset();
+    if (surfaceBytes > 0) {
+        void* ptr = std::aligned_alloc(searchSpaceAlignment, surfaceBytes);
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        data.reset(ptr);
+        METRICS_COUNT(BytesAllocated, surfaceBytes);
+    }
+}
+
+size_t SearchSpace::rowIndex(int PRN, size_t bin) const {
+    if (PRN < 0 || PRN >= static_cast<int>(slots.size()) || slots[PRN] < 0) {
+        throw std::out_of_range("PRN " + std::to_string(PRN) + " is not in the search space");
+    }
+    return static_cast<size_t>(slots[PRN]) * nFrqBins + bin;
+}
+
+template <typename T>
+void SearchSpace::store(int PRN, size_t bin, const T* magnitudes, const SearchRowSummary& summary) {
+    size_t index = rowIndex(PRN, bin);
+    double peak = summary.peak;
+    summaries[index] = summary;
+
+    switch (storageMode) {
+        case SearchSpaceStorage::Float32: {
+            float* out = static_cast<float*>(data.get()) + index * rowStride;
+            for (size_t i = 0; i < numDelays; ++i) {
+                out[i] = static_cast<float>(magnitudes[i]);
+            }
+            break;
+        }
+        case SearchSpaceStorage::UInt16: {
+            // Full scale is the row peak, so the peak of every row is stored exactly
+            uint16_t* out = static_cast<uint16_t*>(data.get()) + index * rowStride;
+            T toCode = peak > 0.0 ? static_cast<T>(65535.0 / peak) : T(0);
+            for (size_t i = 0; i < numDelays; ++i) {
+                out[i] = static_cast<uint16_t>(magnitudes[i] * toCode + T(0.5));
+            }
+            rowScales[index] = static_cast<float>(peak / 65535.0);
+            break;
+        }
+        case SearchSpaceStorage::Summary:
+            break;
+    }
+}
+
+template void SearchSpace::store(int, size_t, const float*, const SearchRowSummary&);
+template void SearchSpace::store(int, size_t, const double*, const SearchRowSummary&);
+
+double SearchSpace::at(int PRN, size_t bin, size_t delay) const {
+    size_t index = rowIndex(PRN, bin);
+    switch (storageMode) {
+        case SearchSpaceStorage::Float32:
+            return static_cast<const float*>(data.get())[index * rowStride + delay];
+        case SearchSpaceStorage::UInt16:
+            return static_cast<const uint16_t*>(data.get())[index * rowStride + delay] * double(rowScales[index]);
+        case SearchSpaceStorage::Summary:
+            break;
+    }
+    throw std::logic_error("Search space surface was not kept (summary storage)");
+}
+
+void SearchSpace::row(int PRN, size_t bin, double* out) const {
+    size_t index = rowIndex(PRN, bin);
+    switch (storageMode) {
+        case SearchSpaceStorage::Float32: {
+            const float* values = static_cast<const float*>(data.get()) + index * rowStride;
+            std::copy(values, values + numDelays, out);
+            return;
+        }
+        case SearchSpaceStorage::UInt16: {
+            const uint16_t* values = static_cast<const uint16_t*>(data.get()) + index * rowStride;
+            double scale = rowScales[index];
+            for (size_t i = 0; i < numDelays; ++i) {
+                out[i] = values[i] * scale;
+            }
+            return;
+        }
+        case SearchSpaceStorage::Summary:
+            break;
+    }
+    throw std::logic_error("Search space surface was not kept (summary storage)");
+}
+
+std::vector<std::vector<double>> SearchSpace::surface(int PRN) const {
+    std::vector<std::vector<double>> prnSurface(nFrqBins, std::vector<double>(numDelays));
+    for (size_t bin = 0; bin < nFrqBins; ++bin) {
+        row(PRN, bin, prnSurface[bin].data());
+    }
+    return prnSurface;
+}
+
+SearchPeakSummary SearchSpace::peak(int PRN) const {
+    SearchPeakSummary best;
+    for (size_t bin = 0; bin < nFrqBins; ++bin) {
+        const SearchRowSummary& summary = rowSummary(PRN, bin);
+        if (bin == 0 || summary.peak > best.peak) {
+            best.peak = summary.peak;
+            best.bin = bin;
+            best.delay = summary.peakDelay;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,84 @@
+#ifndef SEARCH_SPACE_H
+#define SEARCH_SPACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// How the correlation surface is kept after the search
+enum class SearchSpaceStorage {
+    Float32,   // One float per cell
+    UInt16,    // One uint16 per cell, scaled by the maximum of its frequency bin
+    Summary    // No surface, only the per-bin summaries
+};
+
+// Parse Settings::acqSearchSpaceStorage ("float", "uint16", "summary")
+SearchSpaceStorage parseSearchSpaceStorage(const std::string& storage);
+
+// Statistics of one (PRN, frequency bin) correlation row, kept in every storage mode
+struct SearchRowSummary {
+    double peak = 0.0;        // Highest |correlation|^2
+    uint32_t peakDelay = 0;   // Code delay of the peak [search samples]
+    double secondPeak = 0.0;  // Highest |correlation|^2 at least one chip away from the peak
+    double noiseMean = 0.0;   // Mean |correlation|^2 at least one chip away from the peak
+};
+
+// Per-PRN peak over all frequency bins
+struct SearchPeakSummary {
+    double peak = 0.0;
+    size_t bin = 0;
+    size_t delay = 0;
+};
+
+// Acquisition search space [PRN][frequency bin][code delay] in one flat, 64-byte aligned buffer.
+// Rows are padded to a whole number of cache lines and written in place by the correlator, each
+// (PRN, bin) row by exactly one thread. Memory is allocated but not touched up front.
+class SearchSpace {
+public:
+    void initialize(SearchSpaceStorage storage, const std::vector<int>& prns, size_t nFrqBins, size_t samplesPerCode);
+
+    SearchSpaceStorage storage() const { return storageMode; }
+    bool hasSurface() const { return storageMode != SearchSpaceStorage::Summary; }
+    size_t numBins() const { return nFrqBins; }
+    size_t samplesPerCode() const { return numDelays; }
+    size_t bytes() const { return surfaceBytes; }
+
+    // Store the |correlation|^2 of one row and its summary, which the correlator computes while
+    // producing the row. Implemented for float and double magnitudes.
+    template <typename T>
+    void store(int PRN, size_t bin, const T* magnitudes, const SearchRowSummary& summary);
+
+    // Cell value (dequantized); requires hasSurface()
+    double at(int PRN, size_t bin, size_t delay) const;
+
+    // Row of one PRN and bin (dequantized) into out[0, samplesPerCode()); requires hasSurface()
+    void row(int PRN, size_t bin, double* out) const;
+
+    // Full [bin][delay] surface of one PRN, for plotting and export
+    std::vector<std::vector<double>> surface(int PRN) const;
+
+    const SearchRowSummary& rowSummary(int PRN, size_t bin) const { return summaries[rowIndex(PRN, bin)]; }
+    SearchPeakSummary peak(int PRN) const;
+
+private:
+    struct FreeDeleter {
+        void operator()(void* ptr) const { std::free(ptr); }
+    };
+
+    // Index of the (PRN, bin) row; throws for a PRN that was not searched
+    size_t rowIndex(int PRN, size_t bin) const;
+
+    SearchSpaceStorage storageMode = SearchSpaceStorage::Float32;
+    std::vector<int> slots;        // PRN -> row block, -1 if not searched
+    size_t nFrqBins = 0, numDelays = 0;
+    size_t rowStride = 0;          // Elements per padded row
+    size_t surfaceBytes = 0;
+    std::unique_ptr<void, FreeDeleter> data;
+    std::vector<float> rowScales;  // UInt16 dequantization scale of each row
+    std::vector<SearchRowSummary> summaries;
+};
+
+#endif // SEARCH_SPACE_H
@@ -1,4 +1,8 @@
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
 #include "SettingsGps.h"
+#include "Goldencodes.h"
 
 Settings::Settings() {
     // Archivo de entrada con señal sin procesar
@@ -7,6 +11,9 @@ Settings::Settings() {
     // Tipo de señal
     signal = "gpsl1c";
 
+    // Formato de las muestras en el archivo de entrada
+    dataType = "int8";
+
     // Frecuencia intermedia
     IF = 9.548e6; // [Hz]
 
@@ -26,11 +33,217 @@ Settings::Settings() {
 
     // Rango de frecuencia en adquisición
     acqFreqRangekHz = 14; // [kHz]
+    acqFreqStepHz = 125;  // [Hz]
+
+    // Búsqueda gruesa (acqFreqStepHz = 500, 4 veces menos bandas) seguida de estimación fina
+    // de frecuencia solo para los satélites detectados
+    acqFineFrequency = false;
+    acqFineMs = 10;       // [ms]
+    acqFineFftSize = 4096;
+    acqCircularShiftSearch = false; // Una FFT por desfase fino de 125 Hz en lugar de una por banda
     acqTh = 2.5;          // Umbral
 
+    // Integración: acqNonCoherentSums bloques de acqCoherentMs ms (x2 conjuntos candidatos).
+    // El paso en frecuencia es acqFreqStepHz / acqCoherentMs
+    acqCoherentMs = 1;
+    acqNonCoherentSums = 1;
+
+    // Planificación FFTW ("measure"/"patient" guardan wisdom junto al archivo de entrada)
+    fftPlanningEffort = "estimate";
+
+    // Paralelismo de la adquisición: bloques de bandas x PRN repartidos entre hilos
+    acqThreads = 0;
+    acqTileBins = 1;
+    acqTilePrns = 0;
+
+    // Remuestreo previo a la adquisición (FFT de 4096 puntos en lugar de 38192)
+    acqResample = false;
+    acqResampledSamplesPerCode = 0;
+    acqResampleTaps = 256;
+
+    // Precisión de la búsqueda (float: FFTW en simple precisión, mitad de memoria y ancho de banda)
+    acqPrecision = "float";
+    acqValidatePrecision = false;
+    acqPrecisionTolerance = 1e-3;
+
+    // Espacio de búsqueda: float (4 bytes/celda), uint16 (2 bytes/celda) o summary (solo picos por
+    // banda, sin superficie ni gráficas 3D)
+    acqSearchSpaceStorage = "float";
+
+    // Resultados para gráficas: archivos .npy en SW-RCVR-C++/ junto al archivo de entrada,
+    // representados aparte con PlotAcquisition. El espacio de búsqueda se reduce al máximo de
+    // cada grupo de bandas y retardos (1023 retardos = uno por chip)
+    acqDumpResults = true;
+    acqDumpBins = 0;
+    acqDumpDelays = 1023;
+
+    // PRN adquiridos en consola tras cada búsqueda (la adquisición continua los desactiva: imprime
+    // su propia línea por búsqueda)
+    acqPrintResults = true;
+
+    // Resultados de adquisición guardados para el siguiente arranque en caliente
+    acqResultsFile = "";
+
+    // Arranque en caliente: solo se buscan los PRN adquiridos en acqResultsFile (o los de
+    // acqVisibilityFile, líneas "PRN doppler_Hz [fase_código_chips]") en ventanas estrechas
+    acqWarmStart = false;
+    acqVisibilityFile = "";
+    acqWarmFreqWindowHz = 500;   // [Hz]
+    acqWarmCodeWindowChips = 10; // [chips]
+    acqWarmSampleOffset = 0;     // [muestras]
+
+    // Ventanas de código con correlador empaquetado: las muestras sin portadora se recuantifican
+    // a 1 o 2 bits (signo y magnitud) y se correlan con XOR y popcount (0 = correlador en coma
+    // flotante)
+    acqPackedBits = 0;
+
+    // Perfil por máquina de AutotuneAcquisition (tamaño de FFT y remuestreo, precisión, hilos,
+    // bloques de trabajo y esfuerzo de planificación FFTW). Si contiene una sección para esta
+    // máquina, medida con las mismas frecuencias y rejilla de búsqueda, se aplica al arrancar
+    acqProfileFile = "acquisition_profile.txt";
+
+    // Caché de la señal tal como la consume la búsqueda (remuestreada y en la precisión de
+    // búsqueda), mapeada en memoria sin conversión. Se regenera si cambian el archivo de entrada
+    // o los ajustes de los que depende. Desactivada por defecto, porque el directorio de la
+    // grabación puede ser de solo lectura: indicar una ruta con permiso de escritura
+    sampleCacheFile = "";
+    sampleCacheMs = 0;           // [ms]
+
+    // Adquisición continua detrás de un front-end que envía muestras a una FIFO o a un socket
+    // local ("unix:ruta"); un archivo regular se reproduce en tiempo real para pruebas. Se repite
+    // la búsqueda cada streamCadenceMs sobre las últimas muestras recibidas
+    streamInput = "";
+    streamCadenceMs = 1000;      // [ms]
+    streamBufferMs = 200;        // [ms]
+    streamRealTime = true;
+
+    // Tiempos por etapa y contadores (FFT, memoria, muestras por PRN y banda) al final de la
+    // ejecución, en JSON y en formato de texto de Prometheus. Sin efecto si se compila sin
+    // GNSS_METRICS. Vacío: no se guardan, el directorio de la grabación puede ser de solo lectura
+    metricsFile = "";
+
+    // Adquisición en lote: cada línea de batchManifest es "archivo [ajuste=valor ...]" con los
+    // ajustes propios de esa grabación. Todas comparten hilos, planes FFTW y réplicas del código;
+    // se leen batchPrefetchFiles grabaciones por adelantado y los resultados se escriben en un
+    // único CSV
+    batchManifest = "";
+    batchOutputFile = "";
+    batchPrefetchFiles = 2;
+
+    // Seguimiento: lazos DLL y PLL de SoftGNSS. Todos los canales se correlan juntos en una sola
+    // pasada por bloque de muestras
+    dllDampingRatio = 0.7;
+    dllNoiseBandwidth = 2;       // [Hz]
+    dllCorrelatorSpacing = 0.5;  // [chips]
+    pllDampingRatio = 0.7;
+    pllNoiseBandwidth = 25;      // [Hz]
+    // FLL de primer orden sobre el PLL: engancha errores de frecuencia de la adquisición de hasta
+    // 1/(4 ms) = 250 Hz, fuera del alcance del PLL solo
+    fllNoiseBandwidth = 10;      // [Hz]
+
     // Número de canales del receptor
     numberOfChannels = 10;
 
     // Milisegundos a procesar
     msToProcess = 3000; // [ms]
 }
+
+// Valor numérico completo (sin caracteres sobrantes)
+template <typename T>
+static T parseNumber(const std::string& name, const std::string& value) {
+    std::istringstream stream(value);
+    T number;
+    if (!(stream >> number) || !(stream >> std::ws).eof()) {
+        throw std::invalid_argument("Invalid value for " + name + ": " + value);
+    }
+    return number;
+}
+
+static bool parseBool(const std::string& name, const std::string& value) {
+    if (value == "true" || value == "1") {
+        return true;
+    }
+    if (value == "false" || value == "0") {
+        return false;
+    }
+    throw std::invalid_argument("Invalid value for " + name + ": " + value + " (expected true or false)");
+}
+
+// Lista de PRN separados por comas, con rangos "a-b"
+static std::vector<int> parseSatMask(const std::string& value) {
+    std::vector<int> satMask;
+    std::istringstream items(value);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        size_t dash = item.find('-', 1);
+        int first = parseNumber<int>("satMask", item.substr(0, dash));
+        int last = dash == std::string::npos ? first : parseNumber<int>("satMask", item.substr(dash + 1));
+        if (first < 1 || last > caCodeMaxPRN || first > last) {
+            throw std::invalid_argument("Invalid PRN range in satMask: " + item);
+        }
+        for (int PRN = first; PRN <= last; ++PRN) {
+            satMask.push_back(PRN);
+        }
+    }
+    if (satMask.empty()) {
+        throw std::invalid_argument("Empty satMask");
+    }
+    return satMask;
+}
+
+void setSetting(Settings& settings, const std::string& name, const std::string& value) {
+    auto set = [&](const char* field, auto& target) {
+        if (name != field) {
+            return false;
+        }
+        using Field = std::decay_t<decltype(target)>;
+        if constexpr (std::is_same_v<Field, std::string>) {
+            target = value;
+        } else if constexpr (std::is_same_v<Field, bool>) {
+            target = parseBool(name, value);
+        } else {
+            target = parseNumber<Field>(name, value);
+        }
+        return true;
+    };
+
+    if (name == "satMask") {
+        settings.satMask = parseSatMask(value);
+        return;
+    }
+    bool found =
+        set("inputFile", settings.inputFile) || set("signal", settings.signal) ||
+        set("dataType", settings.dataType) || set("IF", settings.IF) ||
+        set("samplingFreq", settings.samplingFreq) || set("codeFreqBasis", settings.codeFreqBasis) ||
+        set("codeLength", settings.codeLength) || set("acqFreqRangekHz", settings.acqFreqRangekHz) ||
+        set("acqFreqStepHz", settings.acqFreqStepHz) || set("acqFineFrequency", settings.acqFineFrequency) ||
+        set("acqFineMs", settings.acqFineMs) || set("acqFineFftSize", settings.acqFineFftSize) ||
+        set("acqCircularShiftSearch", settings.acqCircularShiftSearch) ||
+        set("acqCoherentMs", settings.acqCoherentMs) || set("acqNonCoherentSums", settings.acqNonCoherentSums) ||
+        set("acqTh", settings.acqTh) || set("fftPlanningEffort", settings.fftPlanningEffort) ||
+        set("acqThreads", settings.acqThreads) || set("acqTileBins", settings.acqTileBins) ||
+        set("acqTilePrns", settings.acqTilePrns) || set("acqResample", settings.acqResample) ||
+        set("acqResampledSamplesPerCode", settings.acqResampledSamplesPerCode) ||
+        set("acqResampleTaps", settings.acqResampleTaps) || set("acqPrecision", settings.acqPrecision) ||
+        set("acqValidatePrecision", settings.acqValidatePrecision) ||
+        set("acqPrecisionTolerance", settings.acqPrecisionTolerance) ||
+        set("acqSearchSpaceStorage", settings.acqSearchSpaceStorage) ||
+        set("acqDumpResults", settings.acqDumpResults) || set("acqDumpBins", settings.acqDumpBins) ||
+        set("acqDumpDelays", settings.acqDumpDelays) || set("acqPrintResults", settings.acqPrintResults) ||
+        set("acqResultsFile", settings.acqResultsFile) ||
+        set("acqWarmStart", settings.acqWarmStart) || set("acqVisibilityFile", settings.acqVisibilityFile) ||
+        set("acqWarmFreqWindowHz", settings.acqWarmFreqWindowHz) ||
+        set("acqWarmCodeWindowChips", settings.acqWarmCodeWindowChips) ||
+        set("acqWarmSampleOffset", settings.acqWarmSampleOffset) || set("acqPackedBits", settings.acqPackedBits) ||
+        set("acqProfileFile", settings.acqProfileFile) ||
+        set("sampleCacheFile", settings.sampleCacheFile) || set("sampleCacheMs", settings.sampleCacheMs) ||
+        set("metricsFile", settings.metricsFile) || set("dllDampingRatio", settings.dllDampingRatio) ||
+        set("dllNoiseBandwidth", settings.dllNoiseBandwidth) ||
+        set("dllCorrelatorSpacing", settings.dllCorrelatorSpacing) ||
+        set("pllDampingRatio", settings.pllDampingRatio) || set("pllNoiseBandwidth", settings.pllNoiseBandwidth) ||
+        set("fllNoiseBandwidth", settings.fllNoiseBandwidth) ||
+        set("numberOfChannels", settings.numberOfChannels) || set("msToProcess", settings.msToProcess);
+    if (!found) {
+        throw std::invalid_argument("Unknown setting: " + name);
+    }
+}
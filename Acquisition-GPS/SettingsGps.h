@@ -9,16 +9,64 @@ public:
     // Atributos de configuración
     std::string inputFile;         // Archivo de entrada
     std::string signal;            // Tipo de señal
+    std::string dataType;          // Formato de muestras: int8, int8iq o int16iq
 
     double IF;                     // Frecuencia intermedia [Hz]
     double samplingFreq;           // Frecuencia de muestreo [Hz]
     double codeFreqBasis;          // Frecuencia de código [Hz]
     int codeLength;                // Longitud del código C/A [chips]
 
-    std::vector<int> satMask(32, 0);      // Máscara de satélites
+    std::vector<int> satMask;             // Máscara de satélites (PRN a buscar)
 
     int acqFreqRangekHz;           // Número de bandas de frecuencia [kHz]
+    double acqFreqStepHz;          // Paso de la rejilla de frecuencia para 1 ms coherente [Hz]
+    bool acqFineFrequency;         // Estimación fina de frecuencia tras la detección
+    int acqFineMs;                 // Registro usado en la estimación fina [ms]
+    int acqFineFftSize;            // Puntos de la FFT con relleno de ceros de la estimación fina
+    bool acqCircularShiftSearch;   // Búsqueda Doppler por desplazamiento circular del espectro
+    int acqCoherentMs;             // Tiempo de integración coherente [ms] (1 a 10)
+    int acqNonCoherentSums;        // Número de integraciones coherentes sumadas en potencia
     double acqTh;                  // Umbral de adquisición
+    std::string fftPlanningEffort; // Esfuerzo de planificación FFTW: estimate, measure o patient
+    int acqThreads;                // Hilos de adquisición (0 = todos los disponibles)
+    int acqTileBins;               // Bandas de frecuencia por bloque de trabajo
+    int acqTilePrns;               // PRN por bloque de trabajo (0 = todos)
+    bool acqResample;              // Remuestrear a banda base antes de la adquisición
+    int acqResampledSamplesPerCode;// Muestras por periodo de código tras remuestrear (0 = automático)
+    int acqResampleTaps;           // Longitud del filtro FIR de remuestreo [muestras de entrada]
+    std::string acqPrecision;      // Precisión de la búsqueda: float o double
+    bool acqValidatePrecision;     // Repetir la búsqueda en la otra precisión y comparar detecciones
+    double acqPrecisionTolerance;  // Diferencia relativa máxima de la métrica de pico entre precisiones
+    std::string acqSearchSpaceStorage; // Almacenamiento del espacio de búsqueda: float, uint16 o summary
+    bool acqDumpResults;           // Guardar resultados .npy para PlotAcquisition
+    int acqDumpBins;               // Bandas de frecuencia del espacio de búsqueda guardado (0 = todas)
+    int acqDumpDelays;             // Retardos de código del espacio de búsqueda guardado (0 = todos)
+    bool acqPrintResults;          // Mostrar en consola los PRN adquiridos en cada búsqueda
+    std::string acqResultsFile;    // Archivo binario de resultados de adquisición ("" = no guardar)
+    bool acqWarmStart;             // Arranque en caliente a partir de resultados previos
+    std::string acqVisibilityFile; // Lista de visibilidad/Doppler externa para el arranque en caliente
+    double acqWarmFreqWindowHz;    // Ventana Doppler alrededor de la frecuencia esperada [Hz]
+    double acqWarmCodeWindowChips; // Ventana de código alrededor del retardo esperado [chips] (0 = todo)
+    double acqWarmSampleOffset;    // Muestras de entrada desde el inicio de la búsqueda anterior
+    int acqPackedBits;             // Bits del correlador empaquetado en ventanas de código (0 = desactivado, 1 o 2)
+    std::string acqProfileFile;    // Perfil de ajustes de adquisición por máquina escrito por AutotuneAcquisition ("" = no cargar)
+    std::string sampleCacheFile;   // Caché de la señal preprocesada ("" = sin caché)
+    int sampleCacheMs;             // Señal guardada en la caché [ms] (0 = solo la de adquisición)
+    std::string streamInput;       // Entrada continua: FIFO, "unix:ruta" o archivo ("" = archivo completo)
+    double streamCadenceMs;        // Señal entre búsquedas sobre la ventana deslizante [ms]
+    double streamBufferMs;         // Capacidad del buffer circular de muestras [ms]
+    bool streamRealTime;           // Reproducir un archivo regular a la velocidad de muestreo
+    std::string metricsFile;       // Métricas de la ejecución en metricsFile.json y .prom ("" = no guardar)
+    std::string batchManifest;     // Lista de grabaciones a adquirir en lote ("" = un solo archivo)
+    std::string batchOutputFile;   // Resultados consolidados del lote en CSV ("" = batchManifest.csv)
+    int batchPrefetchFiles;        // Grabaciones leídas por adelantado mientras se busca en otra
+
+    double dllDampingRatio;        // Factor de amortiguamiento del DLL
+    double dllNoiseBandwidth;      // Ancho de banda de ruido del DLL [Hz]
+    double dllCorrelatorSpacing;   // Separación early-prompt-late [chips] (1/n chips)
+    double pllDampingRatio;        // Factor de amortiguamiento del PLL
+    double pllNoiseBandwidth;      // Ancho de banda de ruido del PLL [Hz]
+    double fllNoiseBandwidth;      // Ancho de banda de ruido del FLL que asiste al PLL [Hz] (0 = solo PLL)
 
     int numberOfChannels;          // Número de canales del receptor
     int msToProcess;               // Milisegundos a procesar [ms]
@@ -27,4 +75,9 @@ public:
     Settings();
 };
 
+// Asignar el ajuste name a partir de su texto: números, true/false (o 1/0), cadenas y, para
+// satMask, listas de PRN y rangos ("1,3,5-9"). Lanza invalid_argument si el ajuste no existe o el
+// valor no es válido
+void setSetting(Settings& settings, const std::string& name, const std::string& value);
+
 #endif // SETTINGSGPS_H
@@ -0,0 +1,191 @@
+/*
+########################################################################
+# SignalGenerator.cpp:
+# Deterministic synthetic GPS L1 C/A IF recordings
+#
+#  Project:        sw-rcvr-c++
+#  File:           SignalGenerator.cpp
+#
+########################################################################
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include "SignalGenerator.h"
+#include "Goldencodes.h"
+#include "WorkStealingPool.h"
+
+namespace {
+
+constexpr double gpsL1Frequency = 1575.42e6;
+constexpr int codePeriodsPerBit = 20;          // 50 bit/s navigation data
+constexpr size_t generatorBlock = 4096;        // Samples synthesized per pass (multiple of 16)
+constexpr size_t writeChunk = size_t(1) << 22; // Samples per file write (and per pool tile)
+constexpr int carrierLanes = 16;               // Carrier phasors rotated together (float, restarted every block)
+constexpr int noiseTableBits = 16;
+constexpr uint64_t golden = 0x9E3779B97F4A7C15ull;
+
+// splitmix64 finalizer: a counter-based random number generator when applied to key + n * golden
+uint64_t mix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Standard normal quantiles at the centres of 2^16 equiprobable intervals, so that 16 random bits
+// give one Gaussian sample
+const std::vector<float>& gaussianTable() {
+    static const std::vector<float> table = [] {
+        std::vector<float> values(size_t(1) << noiseTableBits);
+        size_t half = values.size() / 2;
+        for (size_t k = 0; k < half; ++k) {
+            double p = (k + 0.5) / values.size();
+            double low = -10.0, high = 0.0;
+            for (int iteration = 0; iteration < 50; ++iteration) {
+                double middle = 0.5 * (low + high);
+                (0.5 * std::erfc(-middle / std::sqrt(2.0)) < p ? low : high) = middle;
+            }
+            values[k] = static_cast<float>(0.5 * (low + high));
+            values[values.size() - 1 - k] = -values[k];
+        }
+        return values;
+    }();
+    return table;
+}
+
+long long floorDiv(long long a, long long b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+}
+
+SignalGenerator::SignalGenerator(const Settings& settings, const std::vector<SyntheticSatellite>& satellites,
+                                 uint64_t seed, double noiseLevels, bool navigationData)
+    : truth(satellites), seed(seed), noiseLevels(noiseLevels), navigationData(navigationData),
+      codeLength(settings.codeLength) {
+    if (noiseLevels <= 0.0) {
+        throw std::invalid_argument("The noise level must be positive");
+    }
+    for (const SyntheticSatellite& satellite : satellites) {
+        if (satellite.PRN < 1 || satellite.PRN > caCodeMaxPRN) {
+            throw std::invalid_argument("No C/A code for PRN " + std::to_string(satellite.PRN));
+        }
+
+        // C/N0 = A^2 / 2 / N0 with N0 = 2 sigma^2 / fs for real noise of variance sigma^2
+        Channel channel;
+        channel.chips = caCodeTable.chips[satellite.PRN].data();
+        channel.amplitude = 2 * noiseLevels * std::sqrt(std::pow(10.0, satellite.CN0 / 10) / settings.samplingFreq);
+        channel.carrierStep = (settings.IF + satellite.doppler) / settings.samplingFreq;
+        channel.carrierPhase = static_cast<double>(mix64(seed ^ (golden * satellite.PRN)) >> 11) / (uint64_t(1) << 53);
+        channel.codeStep = settings.codeFreqBasis * (1 + satellite.doppler / gpsL1Frequency) / settings.samplingFreq;
+        channel.codeDelay = satellite.codeDelay;
+        channel.dataKey = mix64(seed + golden * (satellite.PRN + caCodeMaxPRN));
+        channels.push_back(channel);
+    }
+}
+
+// Add one satellite to block [first, first + generatorBlock) of signal: the code and data signs
+// chip run by chip run into code[], then the carrier
+void SignalGenerator::addChannel(const Channel& channel, size_t first, float* signal, float* code) const {
+    // Code position of sample first + i: (first + i - codeDelay) * codeStep chips
+    const double position = (static_cast<double>(first) - channel.codeDelay) * channel.codeStep;
+    const double samplesPerChip = 1.0 / channel.codeStep;
+    long long chip = static_cast<long long>(std::floor(position));
+    long long period = floorDiv(chip, codeLength);
+    int chipInCode = static_cast<int>(chip - period * codeLength);
+    auto dataSign = [&](long long period) {
+        bool inverted = navigationData && (mix64(channel.dataKey + golden * floorDiv(period, codePeriodsPerBit)) & 1);
+        return inverted ? -1.0f : 1.0f;
+    };
+    float data = dataSign(period);
+
+    for (size_t i = 0; i < generatorBlock; ++chip) {
+        size_t end = std::min<double>(generatorBlock, std::ceil((chip + 1 - position) * samplesPerChip));
+        std::fill(code + i, code + end, data * channel.chips[chipInCode]);
+        i = std::max(i, end);
+        if (++chipInCode == codeLength) {
+            chipInCode = 0;
+            data = dataSign(++period);
+        }
+    }
+
+    double startPhase = channel.carrierPhase + channel.carrierStep * first;
+    startPhase -= std::floor(startPhase);
+    float carrRe[carrierLanes], carrIm[carrierLanes];
+    for (int l = 0; l < carrierLanes; ++l) {
+        double phase = 2 * M_PI * (startPhase + channel.carrierStep * l);
+        carrRe[l] = static_cast<float>(channel.amplitude * std::cos(phase));
+        carrIm[l] = static_cast<float>(channel.amplitude * std::sin(phase));
+    }
+    const float stepRe = static_cast<float>(std::cos(2 * M_PI * channel.carrierStep * carrierLanes));
+    const float stepIm = static_cast<float>(std::sin(2 * M_PI * channel.carrierStep * carrierLanes));
+    for (size_t i = 0; i < generatorBlock; i += carrierLanes) {
+        for (int l = 0; l < carrierLanes; ++l) {
+            signal[i + l] += code[i + l] * carrRe[l];
+            float rotated = carrRe[l] * stepRe - carrIm[l] * stepIm;
+            carrIm[l] = carrRe[l] * stepIm + carrIm[l] * stepRe;
+            carrRe[l] = rotated;
+        }
+    }
+}
+
+void SignalGenerator::generate(size_t first, size_t count, int8_t* out) const {
+    const std::vector<float>& gaussian = gaussianTable();
+    const float noiseScale = static_cast<float>(noiseLevels);
+    const uint64_t noiseKey = mix64(seed);
+    std::vector<float> signal(generatorBlock), code(generatorBlock);
+
+    // Whole blocks aligned on multiples of generatorBlock, so that a sample does not depend on the
+    // requested range
+    for (size_t start = first / generatorBlock * generatorBlock; start < first + count; start += generatorBlock) {
+        std::fill(signal.begin(), signal.end(), 0.0f);
+        for (const Channel& channel : channels) {
+            addChannel(channel, start, signal.data(), code.data());
+        }
+
+        // 16 random bits per noise sample, 4 samples per 64 bits of the counter index / 4
+        for (size_t i = 0; i < generatorBlock; i += 4) {
+            uint64_t bits = mix64(noiseKey + golden * ((start + i) >> 2));
+            for (int k = 0; k < 4; ++k) {
+                signal[i + k] += noiseScale * gaussian[(bits >> (16 * k)) & 0xFFFF];
+            }
+        }
+
+        // Round half away from zero after saturation
+        size_t begin = std::max(first, start) - start;
+        size_t end = std::min(first + count, start + generatorBlock) - start;
+        for (size_t i = begin; i < end; ++i) {
+            float value = std::clamp(signal[i], -127.0f, 127.0f);
+            out[start + i - first] = static_cast<int8_t>(value + (value < 0.0f ? -0.5f : 0.5f));
+        }
+    }
+}
+
+void SignalGenerator::write(const std::string& path, size_t numSamples) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot create " + path);
+    }
+
+    // Chunks are generated in parallel and written in order
+    WorkStealingPool pool(0);
+    size_t batchChunks = pool.size();
+    std::vector<std::vector<int8_t>> chunks(batchChunks, std::vector<int8_t>(writeChunk));
+    for (size_t first = 0; first < numSamples; first += batchChunks * writeChunk) {
+        size_t numChunks = std::min(batchChunks, (numSamples - first + writeChunk - 1) / writeChunk);
+        pool.run(numChunks, [&](size_t chunk, int) {
+            size_t chunkFirst = first + chunk * writeChunk;
+            generate(chunkFirst, std::min(writeChunk, numSamples - chunkFirst), chunks[chunk].data());
+        });
+        for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+            size_t chunkFirst = first + chunk * writeChunk;
+            file.write(reinterpret_cast<const char*>(chunks[chunk].data()),
+                       std::min(writeChunk, numSamples - chunkFirst));
+        }
+    }
+    if (!file) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
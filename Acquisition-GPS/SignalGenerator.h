@@ -0,0 +1,57 @@
+#ifndef SIGNAL_GENERATOR_H
+#define SIGNAL_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SettingsGps.h"
+
+// One simulated GPS L1 C/A signal
+struct SyntheticSatellite {
+    int PRN = 1;
+    double doppler = 0.0;    // Carrier Doppler [Hz]; the code rate follows it
+    double codeDelay = 0.0;  // Sample where a code period starts, as AcqResults::codeDelay [samples]
+    double CN0 = 45.0;       // Carrier to noise density [dB-Hz]
+};
+
+// Deterministic real int8 IF recording in the format of GPS_RECORDED_RAW_SIGNAL_*.dat (dataType
+// "int8") at settings.samplingFreq and settings.IF: the C/A signals of the satellites, with code
+// Doppler and 50 bit/s navigation data, plus white Gaussian noise of noiseLevels quantization
+// levels RMS. Every sample is a function of its index and the seed only, so a recording can be
+// generated in any order and in pieces of any size.
+class SignalGenerator {
+public:
+    SignalGenerator(const Settings& settings, const std::vector<SyntheticSatellite>& satellites, uint64_t seed,
+                    double noiseLevels = 8.0, bool navigationData = true);
+
+    // Samples [first, first + count) of the recording
+    void generate(size_t first, size_t count, int8_t* out) const;
+
+    // Write the first numSamples samples to path
+    void write(const std::string& path, size_t numSamples) const;
+
+    const std::vector<SyntheticSatellite>& satellites() const { return truth; }
+
+private:
+    struct Channel {
+        const int8_t* chips;
+        double amplitude;        // [quantization levels]
+        double carrierStep;      // [cycles per sample]
+        double carrierPhase;     // At sample 0 [cycles]
+        double codeStep;         // [chips per sample]
+        double codeDelay;        // [samples]
+        uint64_t dataKey;
+    };
+
+    void addChannel(const Channel& channel, size_t first, float* signal, float* code) const;
+
+    std::vector<SyntheticSatellite> truth;
+    std::vector<Channel> channels;
+    uint64_t seed;
+    double noiseLevels;
+    bool navigationData;
+    int codeLength;
+};
+
+#endif // SIGNAL_GENERATOR_H
@@ -0,0 +1,80 @@
+#ifndef SPSC_RING_BUFFER_H
+#define SPSC_RING_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Lock-free single-producer/single-consumer ring buffer of trivially copyable elements. The
+// capacity is rounded up to a power of two; the read and write positions are free-running
+// counters, each written by one thread only, on separate cache lines. write() must only be
+// called from the producer thread and read() from the consumer thread.
+template <typename T>
+class SpscRingBuffer {
+public:
+    explicit SpscRingBuffer(size_t minCapacity) {
+        size_t capacity = 1;
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        buffer.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    size_t capacity() const { return buffer.size(); }
+
+    // Elements ready to be read (exact for the consumer, a lower bound for the producer)
+    size_t size() const {
+        return writePosition.load(std::memory_order_acquire) - readPosition.load(std::memory_order_acquire);
+    }
+
+    // Free space (exact for the producer, a lower bound for the consumer)
+    size_t space() const { return capacity() - size(); }
+
+    // Producer: append up to count elements; returns how many were written
+    size_t write(const T* data, size_t count) {
+        size_t write = writePosition.load(std::memory_order_relaxed);
+        size_t read = readPosition.load(std::memory_order_acquire);
+        count = std::min(count, capacity() - (write - read));
+        copyIn(write, data, count);
+        writePosition.store(write + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer: remove up to count elements into data; returns how many were read
+    size_t read(T* data, size_t count) {
+        size_t read = readPosition.load(std::memory_order_relaxed);
+        size_t write = writePosition.load(std::memory_order_acquire);
+        count = std::min(count, write - read);
+        copyOut(read, data, count);
+        readPosition.store(read + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    // Copy in at most two runs around the end of the buffer
+    void copyIn(size_t position, const T* data, size_t count) {
+        size_t start = position & mask;
+        size_t first = std::min(count, buffer.size() - start);
+        std::copy(data, data + first, buffer.begin() + start);
+        std::copy(data + first, data + count, buffer.begin());
+    }
+
+    void copyOut(size_t position, T* data, size_t count) const {
+        size_t start = position & mask;
+        size_t first = std::min(count, buffer.size() - start);
+        std::copy(buffer.begin() + start, buffer.begin() + start + first, data);
+        std::copy(buffer.begin(), buffer.begin() + (count - first), data + first);
+    }
+
+    std::vector<T> buffer;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> writePosition{0};  // Written by the producer only
+    alignas(64) std::atomic<size_t> readPosition{0};   // Written by the consumer only
+};
+
+#endif // SPSC_RING_BUFFER_H
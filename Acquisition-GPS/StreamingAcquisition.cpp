@@ -0,0 +1,313 @@
+/*
+########################################################################
+# StreamingAcquisition.cpp:
+# Continuous acquisition from a FIFO, local socket or replayed file
+#
+#  Project:        sw-rcvr-c++
+#  File:           StreamingAcquisition.cpp
+#
+########################################################################
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "StreamingAcquisition.h"
+#include "SampleSource.h"
+#include "SpscRingBuffer.h"
+#include "Metrics.h"
+#include "WorkStealingPool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Sequence number and arrival time of a block in the ring buffer
+struct BlockStamp {
+    size_t index;
+    Clock::time_point arrival;
+};
+
+constexpr char socketPrefix[] = "unix:";
+constexpr auto consumerPollInterval = std::chrono::microseconds(200);
+constexpr int producerPollTimeoutMs = 100;
+
+// Listen on a local socket and accept the front-end connection
+int acceptFrontEnd(const std::string& path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Socket path too long: " + path);
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw std::runtime_error(std::string("Cannot create socket: ") + std::strerror(errno));
+    }
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 1) != 0) {
+        int error = errno;
+        close(listener);
+        throw std::runtime_error("Cannot listen on " + path + ": " + std::strerror(error));
+    }
+
+    int fd;
+    do {
+        fd = accept(listener, nullptr, nullptr);
+    } while (fd < 0 && errno == EINTR);
+    int error = errno;
+    close(listener);
+    unlink(path.c_str());
+    if (fd < 0) {
+        throw std::runtime_error("Cannot accept on " + path + ": " + std::strerror(error));
+    }
+    return fd;
+}
+
+// Open Settings::streamInput; isFile tells whether it is a regular file (which can be paced)
+int openStream(const std::string& input, bool& isFile) {
+    isFile = false;
+    if (input.compare(0, sizeof(socketPrefix) - 1, socketPrefix) == 0) {
+        return acceptFrontEnd(input.substr(sizeof(socketPrefix) - 1));
+    }
+
+    int fd = open(input.c_str(), O_RDONLY);  // Blocks on a FIFO until the writer opens it
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + input + ": " + std::strerror(errno));
+    }
+    struct stat info;
+    isFile = fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+    return fd;
+}
+
+// Read exactly count bytes unless the stream ends or stop is set; returns the bytes read. The
+// read waits in poll so that a stop is seen within producerPollTimeoutMs even on an idle FIFO,
+// where closing or shutting down the descriptor would not wake a blocked read
+size_t readFully(int fd, char* data, size_t count, const std::atomic<bool>& stop) {
+    size_t done = 0;
+    while (done < count && !stop) {
+        pollfd ready = {fd, POLLIN, 0};
+        int events = poll(&ready, 1, producerPollTimeoutMs);
+        if (events < 0 && errno != EINTR) {
+            throw std::runtime_error(std::string("Cannot poll the sample stream: ") + std::strerror(errno));
+        }
+        if (events <= 0) {
+            continue;
+        }
+        ssize_t n = read(fd, data + done, count - done);
+        if (n > 0) {
+            done += n;
+        } else if (n == 0) {
+            break;
+        } else if (errno != EINTR) {
+            throw std::runtime_error(std::string("Cannot read the sample stream: ") + std::strerror(errno));
+        }
+    }
+    return done;
+}
+
+}
+
+template <typename T>
+static StreamStatistics runStream(const Settings& settings, const StreamCallback& onAcquisition) {
+    SampleFormat format = parseSampleFormat(settings.dataType);
+    size_t samplesPerCode = static_cast<size_t>(
+        std::round(settings.samplingFreq * settings.codeLength / settings.codeFreqBasis));
+    size_t blockBytes = samplesPerCode * sampleBytes(format);
+    std::chrono::duration<double> blockPeriod(samplesPerCode / settings.samplingFreq);
+    double blockMs = 1e3 * blockPeriod.count();
+
+    size_t windowSamples = acquisitionSampleCount(settings);
+    size_t windowBlocks = (windowSamples + samplesPerCode - 1) / samplesPerCode;
+    size_t cadenceBlocks = std::max<size_t>(1, static_cast<size_t>(std::lround(settings.streamCadenceMs / blockMs)));
+    size_t ringBlocks = std::max<size_t>(2, static_cast<size_t>(std::ceil(settings.streamBufferMs / blockMs)));
+
+    // Everything the session needs is allocated here
+    SpscRingBuffer<char> ring(ringBlocks * blockBytes);
+    SpscRingBuffer<BlockStamp> stamps(ring.capacity() / blockBytes);
+    std::vector<char> window(windowBlocks * blockBytes);  // Circular, one slot per block
+    std::vector<char> job(window.size());                 // Window handed to the worker, oldest block first
+    std::vector<std::complex<T>> signal(windowSamples);
+
+    StreamStatistics stats;
+    stats.memoryBytes = ring.capacity() + stamps.capacity() * sizeof(BlockStamp) + window.size() + job.size()
+                      + signal.size() * sizeof(std::complex<T>);
+
+    bool isFile;
+    int fd = openStream(settings.streamInput, isFile);
+    bool pace = isFile && settings.streamRealTime;
+
+    // Producer: whole blocks only, so the ring always holds complete samples. A block that does
+    // not fit is dropped, as a real-time front-end cannot wait for the consumer.
+    std::atomic<bool> producerDone{false};
+    std::atomic<bool> stopProducer{false};
+    std::atomic<size_t> blocksDropped{0};
+    std::exception_ptr producerError;
+    std::thread producer([&] {
+        try {
+            std::vector<char> block(blockBytes);
+            Clock::time_point start = Clock::now();
+            for (size_t index = 0; readFully(fd, block.data(), blockBytes, stopProducer) == blockBytes; ++index) {
+                if (pace) {
+                    std::this_thread::sleep_until(
+                        start + std::chrono::duration_cast<Clock::duration>((index + 1) * blockPeriod));
+                }
+                if (ring.space() >= blockBytes && stamps.space() >= 1) {
+                    ring.write(block.data(), blockBytes);
+                    BlockStamp stamp = {index, Clock::now()};
+                    stamps.write(&stamp, 1);
+                } else {
+                    ++blocksDropped;
+                }
+            }
+        } catch (...) {
+            producerError = std::current_exception();
+        }
+        producerDone = true;
+    });
+
+    // Acquisition worker: one search at a time over the last window handed to it, on threads
+    // kept for the whole stream. The results only reach the caller through onAcquisition.
+    Settings searchSettings = settings;
+    searchSettings.acqPrintResults = false;
+    WorkStealingPool pool(settings.acqThreads);
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    bool hasJob = false, busy = false, stopping = false;
+    BlockStamp jobStamp = {};
+    std::exception_ptr workerError;
+    std::thread worker([&] {
+        for (size_t run = 0;; ++run) {
+            BlockStamp stamp;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                jobReady.wait(lock, [&] { return hasJob || stopping; });
+                if (!hasJob) {
+                    return;
+                }
+                hasJob = false;
+                stamp = jobStamp;
+            }
+            try {
+                {
+                    METRICS_STAGE(InputLoading);
+                    METRICS_COUNT(SamplesLoaded, windowSamples);
+                    convertSamples(format, job.data(), windowSamples, signal.data());
+                }
+                StreamAcquisition acquisition;
+                acquisition.run = run;
+                acquisition.streamTimeMs = (stamp.index + 1) * blockMs;
+                acquisition.acqResults = searchGpsL1C(searchSettings, signal, AcquisitionCallback(), &pool);
+                acquisition.latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - stamp.arrival).count();
+                if (onAcquisition) {
+                    onAcquisition(acquisition);
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                ++stats.runs;
+                stats.meanLatencyMs += (acquisition.latencyMs - stats.meanLatencyMs) / stats.runs;
+                stats.maxLatencyMs = std::max(stats.maxLatencyMs, acquisition.latencyMs);
+                busy = false;
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                workerError = std::current_exception();
+                busy = false;
+                return;
+            }
+        }
+    });
+
+    // Consumer: slide the window one block at a time
+    size_t windowFill = 0;  // Consecutive blocks in the window
+    size_t nextIndex = 0;
+    size_t lastRunIndex = 0;
+    bool hasRun = false;
+    for (;;) {
+        stats.peakBufferedBytes = std::max(stats.peakBufferedBytes, ring.size());
+        if (stamps.size() == 0) {
+            if (producerDone && stamps.size() == 0) {
+                break;
+            }
+            std::this_thread::sleep_for(consumerPollInterval);
+            continue;
+        }
+
+        BlockStamp stamp;
+        stamps.read(&stamp, 1);
+        ring.read(window.data() + (stamp.index % windowBlocks) * blockBytes, blockBytes);
+        ++stats.blocksReceived;
+        windowFill = stamp.index == nextIndex ? std::min(windowFill + 1, windowBlocks) : 1;
+        nextIndex = stamp.index + 1;
+
+        if (windowFill < windowBlocks || (hasRun && stamp.index - lastRunIndex < cadenceBlocks)) {
+            continue;
+        }
+        hasRun = true;
+        lastRunIndex = stamp.index;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (workerError) {
+            break;
+        }
+        if (busy) {
+            ++stats.skippedRuns;
+            continue;
+        }
+        size_t oldest = (stamp.index + 1) % windowBlocks;
+        size_t split = (windowBlocks - oldest) * blockBytes;
+        std::copy(window.begin() + oldest * blockBytes, window.end(), job.begin());
+        std::copy(window.begin(), window.begin() + oldest * blockBytes, job.begin() + split);
+        jobStamp = stamp;
+        hasJob = busy = true;
+        jobReady.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobReady.notify_one();
+    }
+    worker.join();
+    // Only after a worker failure is the producer still running: it sees the stop at its next poll
+    stopProducer = true;
+    producer.join();
+    close(fd);
+
+    if (workerError) {
+        std::rethrow_exception(workerError);
+    }
+    if (producerError) {
+        std::rethrow_exception(producerError);
+    }
+    stats.blocksDropped = blocksDropped;
+    return stats;
+}
+
+StreamStatistics streamingAcquisition(const Settings& settings, const StreamCallback& onAcquisition) {
+    if (settings.streamInput.empty()) {
+        throw std::invalid_argument("No stream input configured");
+    }
+    if (settings.streamCadenceMs <= 0 || settings.streamBufferMs <= 0) {
+        throw std::invalid_argument("streamCadenceMs and streamBufferMs must be positive");
+    }
+    return settings.acqPrecision == "float" ? runStream<float>(settings, onAcquisition)
+                                            : runStream<double>(settings, onAcquisition);
+}
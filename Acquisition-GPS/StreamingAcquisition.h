@@ -0,0 +1,42 @@
+#ifndef STREAMING_ACQUISITION_H
+#define STREAMING_ACQUISITION_H
+
+#include <cstddef>
+#include <functional>
+#include "SettingsGps.h"
+#include "Acquisition.h"
+
+// One search over the sliding window of a sample stream
+struct StreamAcquisition {
+    size_t run = 0;             // Search number, from 0
+    double streamTimeMs = 0.0;  // Stream time at the end of the window [ms]
+    double latencyMs = 0.0;     // From the arrival of the newest window block to the results [ms]
+    AcqResults acqResults;
+};
+
+// Totals of a streaming session
+struct StreamStatistics {
+    size_t blocksReceived = 0;     // 1 ms blocks read from the stream
+    size_t blocksDropped = 0;      // Blocks lost because the ring buffer was full
+    size_t runs = 0;               // Searches completed
+    size_t skippedRuns = 0;        // Searches not started because the previous one was still running
+    double meanLatencyMs = 0.0;
+    double maxLatencyMs = 0.0;
+    size_t memoryBytes = 0;        // Ring buffer, window and search input, allocated once
+    size_t peakBufferedBytes = 0;  // Highest ring buffer occupancy
+};
+
+using StreamCallback = std::function<void(const StreamAcquisition&)>;
+
+// Acquire continuously from Settings::streamInput: a FIFO, a local socket "unix:<path>" (listened
+// on until the front-end connects) or a regular file, replayed at the sampling rate when
+// Settings::streamRealTime is set. A producer thread reads 1 ms code-period blocks of raw samples
+// into a lock-free ring buffer of Settings::streamBufferMs. The consumer keeps a sliding window
+// of acquisitionSampleCount() samples and, every Settings::streamCadenceMs of signal, hands a
+// copy of it to the acquisition worker, which searches on a thread pool kept for the session and
+// calls onAcquisition with the results (the search itself prints nothing). A search
+// still running at the next cadence tick skips that tick; a gap left by dropped blocks restarts
+// the window. All buffers are allocated up front. Returns when the stream ends.
+StreamStatistics streamingAcquisition(const Settings& settings, const StreamCallback& onAcquisition);
+
+#endif // STREAMING_ACQUISITION_H
@@ -0,0 +1,496 @@
+/*
+########################################################################
+# Tracking.cpp:
+# Batched code and carrier tracking of the acquired GPS L1 C/A signals
+#
+#  Project:        sw-rcvr-c++
+#  File:           Tracking.cpp
+#
+########################################################################
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "Tracking.h"
+#include "Goldencodes.h"
+#include "Metrics.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define TRACKING_X86 1
+#endif
+
+constexpr double gpsL1Frequency = 1575.42e6;  // For the Doppler aiding of the initial code rate
+
+// E/P/L table bits: set when the chip of the early, prompt or late replica is -1
+constexpr int earlyBit = 1, promptBit = 2, lateBit = 4;
+
+namespace {
+
+// Lanes of one kernel call, at the first sample of the segment
+struct KernelLanes {
+    int numLanes;               // Multiple of trackingLanes
+    const float* carrRe;        // Carrier phasor exp(-j*theta)
+    const float* carrIm;
+    const float* stepRe;        // Phasor rotation per sample
+    const float* stepIm;
+    const float* codePhase;     // Code phase [table entries]
+    const float* codeStep;      // Code phase advance per sample [table entries]
+    const int32_t* tableOffset; // Start of the E/P/L table of every lane
+    const int8_t* tables;
+    float* correlations;        // Out: 6 x numLanes, I_E, Q_E, I_P, Q_P, I_L, Q_L
+};
+
+template <typename T>
+using CorrelatorKernel = void (*)(const std::complex<T>* samples, int count, const KernelLanes& lanes);
+
+// Portable kernel, one lane at a time over the (cached) segment
+template <typename T>
+void correlateScalar(const std::complex<T>* samples, int count, const KernelLanes& lanes) {
+    int n = lanes.numLanes;
+    for (int l = 0; l < n; ++l) {
+        float carrRe = lanes.carrRe[l], carrIm = lanes.carrIm[l];
+        const int8_t* table = lanes.tables + lanes.tableOffset[l];
+        float iE = 0, qE = 0, iP = 0, qP = 0, iL = 0, qL = 0;
+        for (int i = 0; i < count; ++i) {
+            float x = static_cast<float>(samples[i].real());
+            float y = static_cast<float>(samples[i].imag());
+            float bRe = x * carrRe - y * carrIm;
+            float bIm = x * carrIm + y * carrRe;
+            int bits = table[static_cast<int>(lanes.codePhase[l] + i * lanes.codeStep[l])];
+            float early = bits & earlyBit ? -1.0f : 1.0f;
+            float prompt = bits & promptBit ? -1.0f : 1.0f;
+            float late = bits & lateBit ? -1.0f : 1.0f;
+            iE += early * bRe;
+            qE += early * bIm;
+            iP += prompt * bRe;
+            qP += prompt * bIm;
+            iL += late * bRe;
+            qL += late * bIm;
+
+            float rotated = carrRe * lanes.stepRe[l] - carrIm * lanes.stepIm[l];
+            carrIm = carrRe * lanes.stepIm[l] + carrIm * lanes.stepRe[l];
+            carrRe = rotated;
+        }
+        float* out = lanes.correlations;
+        out[l] = iE;
+        out[n + l] = qE;
+        out[2 * n + l] = iP;
+        out[3 * n + l] = qP;
+        out[4 * n + l] = iL;
+        out[5 * n + l] = qL;
+    }
+}
+
+#ifdef TRACKING_X86
+
+// GCC 12 reports _mm512_undefined_epi32() inside the AVX-512 gather as maybe-uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+
+// Apply a replica sign (bit 31 of sign) to a register of baseband values
+__attribute__((target("avx512f")))
+inline __m512 flipSign(__m512 value, __m512i sign) {
+    return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(value), sign));
+}
+
+// AVX-512 kernel: 16 channels per pass, every sample broadcast to all of them. The E/P/L signs
+// of the 16 channels come from one gather of their table bytes.
+template <typename T>
+__attribute__((target("avx512f")))
+void correlateAvx512(const std::complex<T>* samples, int count, const KernelLanes& lanes) {
+    const __m512i signBit = _mm512_set1_epi32(INT32_MIN);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    int n = lanes.numLanes;
+    for (int g = 0; g < n; g += trackingLanes) {
+        __m512 carrRe = _mm512_loadu_ps(lanes.carrRe + g);
+        __m512 carrIm = _mm512_loadu_ps(lanes.carrIm + g);
+        const __m512 stepRe = _mm512_loadu_ps(lanes.stepRe + g);
+        const __m512 stepIm = _mm512_loadu_ps(lanes.stepIm + g);
+        const __m512 codePhase = _mm512_loadu_ps(lanes.codePhase + g);
+        const __m512 codeStep = _mm512_loadu_ps(lanes.codeStep + g);
+        const __m512i offset = _mm512_loadu_si512(lanes.tableOffset + g);
+        __m512 iE = _mm512_setzero_ps(), qE = _mm512_setzero_ps();
+        __m512 iP = _mm512_setzero_ps(), qP = _mm512_setzero_ps();
+        __m512 iL = _mm512_setzero_ps(), qL = _mm512_setzero_ps();
+        __m512 k = _mm512_setzero_ps();
+
+        for (int i = 0; i < count; ++i) {
+            __m512 x = _mm512_set1_ps(static_cast<float>(samples[i].real()));
+            __m512 y = _mm512_set1_ps(static_cast<float>(samples[i].imag()));
+            __m512 bRe = _mm512_fmsub_ps(x, carrRe, _mm512_mul_ps(y, carrIm));
+            __m512 bIm = _mm512_fmadd_ps(x, carrIm, _mm512_mul_ps(y, carrRe));
+
+            __m512i entry = _mm512_add_epi32(_mm512_cvttps_epi32(_mm512_fmadd_ps(k, codeStep, codePhase)), offset);
+            __m512i bits = _mm512_i32gather_epi32(entry, lanes.tables, 1);
+            __m512i early = _mm512_slli_epi32(bits, 31);
+            __m512i prompt = _mm512_and_si512(_mm512_slli_epi32(bits, 30), signBit);
+            __m512i late = _mm512_and_si512(_mm512_slli_epi32(bits, 29), signBit);
+            iE = _mm512_add_ps(iE, flipSign(bRe, early));
+            qE = _mm512_add_ps(qE, flipSign(bIm, early));
+            iP = _mm512_add_ps(iP, flipSign(bRe, prompt));
+            qP = _mm512_add_ps(qP, flipSign(bIm, prompt));
+            iL = _mm512_add_ps(iL, flipSign(bRe, late));
+            qL = _mm512_add_ps(qL, flipSign(bIm, late));
+
+            __m512 rotated = _mm512_fmsub_ps(carrRe, stepRe, _mm512_mul_ps(carrIm, stepIm));
+            carrIm = _mm512_fmadd_ps(carrRe, stepIm, _mm512_mul_ps(carrIm, stepRe));
+            carrRe = rotated;
+            k = _mm512_add_ps(k, one);
+        }
+
+        float* out = lanes.correlations + g;
+        _mm512_storeu_ps(out, iE);
+        _mm512_storeu_ps(out + n, qE);
+        _mm512_storeu_ps(out + 2 * n, iP);
+        _mm512_storeu_ps(out + 3 * n, qP);
+        _mm512_storeu_ps(out + 4 * n, iL);
+        _mm512_storeu_ps(out + 5 * n, qL);
+    }
+}
+
+// Apply a replica sign (bit 31 of sign) to a register of baseband values
+__attribute__((target("avx2,fma")))
+inline __m256 flipSign(__m256 value, __m256i sign) {
+    return _mm256_castsi256_ps(_mm256_xor_si256(_mm256_castps_si256(value), sign));
+}
+
+// AVX2 kernel: the 16 channels of a pass are two halves of 8, both updated from the same
+// broadcast sample so that every sample is still loaded once per pass. The E/P/L signs of each
+// half come from one gather of their table bytes.
+template <typename T>
+__attribute__((target("avx2,fma")))
+void correlateAvx2(const std::complex<T>* samples, int count, const KernelLanes& lanes) {
+    constexpr int half = 8;
+    const __m256i signBit = _mm256_set1_epi32(INT32_MIN);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const int* tables = reinterpret_cast<const int*>(lanes.tables);
+    int n = lanes.numLanes;
+    for (int g = 0; g < n; g += trackingLanes) {
+        __m256 carrRe[2], carrIm[2], stepRe[2], stepIm[2], codePhase[2], codeStep[2];
+        __m256i offset[2];
+        __m256 iE[2], qE[2], iP[2], qP[2], iL[2], qL[2];
+        for (int h = 0; h < 2; ++h) {
+            int l = g + h * half;
+            carrRe[h] = _mm256_loadu_ps(lanes.carrRe + l);
+            carrIm[h] = _mm256_loadu_ps(lanes.carrIm + l);
+            stepRe[h] = _mm256_loadu_ps(lanes.stepRe + l);
+            stepIm[h] = _mm256_loadu_ps(lanes.stepIm + l);
+            codePhase[h] = _mm256_loadu_ps(lanes.codePhase + l);
+            codeStep[h] = _mm256_loadu_ps(lanes.codeStep + l);
+            offset[h] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.tableOffset + l));
+            iE[h] = qE[h] = iP[h] = qP[h] = iL[h] = qL[h] = _mm256_setzero_ps();
+        }
+        __m256 k = _mm256_setzero_ps();
+
+        for (int i = 0; i < count; ++i) {
+            __m256 x = _mm256_set1_ps(static_cast<float>(samples[i].real()));
+            __m256 y = _mm256_set1_ps(static_cast<float>(samples[i].imag()));
+            for (int h = 0; h < 2; ++h) {
+                __m256 bRe = _mm256_fmsub_ps(x, carrRe[h], _mm256_mul_ps(y, carrIm[h]));
+                __m256 bIm = _mm256_fmadd_ps(x, carrIm[h], _mm256_mul_ps(y, carrRe[h]));
+
+                __m256i entry = _mm256_add_epi32(
+                    _mm256_cvttps_epi32(_mm256_fmadd_ps(k, codeStep[h], codePhase[h])), offset[h]);
+                __m256i bits = _mm256_i32gather_epi32(tables, entry, 1);
+                __m256i early = _mm256_slli_epi32(bits, 31);
+                __m256i prompt = _mm256_and_si256(_mm256_slli_epi32(bits, 30), signBit);
+                __m256i late = _mm256_and_si256(_mm256_slli_epi32(bits, 29), signBit);
+                iE[h] = _mm256_add_ps(iE[h], flipSign(bRe, early));
+                qE[h] = _mm256_add_ps(qE[h], flipSign(bIm, early));
+                iP[h] = _mm256_add_ps(iP[h], flipSign(bRe, prompt));
+                qP[h] = _mm256_add_ps(qP[h], flipSign(bIm, prompt));
+                iL[h] = _mm256_add_ps(iL[h], flipSign(bRe, late));
+                qL[h] = _mm256_add_ps(qL[h], flipSign(bIm, late));
+
+                __m256 rotated = _mm256_fmsub_ps(carrRe[h], stepRe[h], _mm256_mul_ps(carrIm[h], stepIm[h]));
+                carrIm[h] = _mm256_fmadd_ps(carrRe[h], stepIm[h], _mm256_mul_ps(carrIm[h], stepRe[h]));
+                carrRe[h] = rotated;
+            }
+            k = _mm256_add_ps(k, one);
+        }
+
+        for (int h = 0; h < 2; ++h) {
+            float* out = lanes.correlations + g + h * half;
+            _mm256_storeu_ps(out, iE[h]);
+            _mm256_storeu_ps(out + n, qE[h]);
+            _mm256_storeu_ps(out + 2 * n, iP[h]);
+            _mm256_storeu_ps(out + 3 * n, qP[h]);
+            _mm256_storeu_ps(out + 4 * n, iL[h]);
+            _mm256_storeu_ps(out + 5 * n, qL[h]);
+        }
+    }
+}
+
+#pragma GCC diagnostic pop
+
+#endif // TRACKING_X86
+
+// Pick the widest kernel the CPU supports
+template <typename T>
+CorrelatorKernel<T> selectKernel() {
+#ifdef TRACKING_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return correlateAvx512<T>;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return correlateAvx2<T>;
+    }
+#endif
+    return correlateScalar<T>;
+}
+
+// Loop filter time constants from the noise bandwidth [Hz], damping ratio and loop gain
+// (calcLoopCoef of SoftGNSS)
+void loopCoefficients(double noiseBandwidth, double dampingRatio, double gain, double& tau1, double& tau2) {
+    double naturalFreq = noiseBandwidth * 8 * dampingRatio / (4 * dampingRatio * dampingRatio + 1);
+    tau1 = gain / (naturalFreq * naturalFreq);
+    tau2 = 2 * dampingRatio / naturalFreq;
+}
+
+}
+
+double ChannelTrack::phaseLockIndicator(size_t periods) const {
+    size_t first = I_P.size() - std::min(periods, I_P.size());
+    double inPhase = 0.0, quadrature = 0.0;
+    for (size_t k = first; k < I_P.size(); ++k) {
+        inPhase += I_P[k] * I_P[k];
+        quadrature += Q_P[k] * Q_P[k];
+    }
+    return inPhase + quadrature > 0.0 ? (inPhase - quadrature) / (inPhase + quadrature) : 0.0;
+}
+
+TrackingChannels::TrackingChannels(const Settings& settings, const AcqResults& acqResults)
+    : samplingFreq(settings.samplingFreq), codeFreqBasis(settings.codeFreqBasis), codeLength(settings.codeLength),
+      periodTime(settings.codeLength / settings.codeFreqBasis) {
+    double resolution = 1.0 / settings.dllCorrelatorSpacing;
+    if (!(settings.dllCorrelatorSpacing > 0.0 && settings.dllCorrelatorSpacing <= 1.0)
+        || std::abs(resolution - std::round(resolution)) > 1e-9) {
+        throw std::invalid_argument("dllCorrelatorSpacing must be 1/n chips (e.g. 0.5 or 0.25)");
+    }
+    if (settings.numberOfChannels < 1) {
+        throw std::invalid_argument("numberOfChannels must be positive");
+    }
+    tableResolution = static_cast<int>(std::lround(resolution));
+    loopCoefficients(settings.dllNoiseBandwidth, settings.dllDampingRatio, 1.0, tau1Code, tau2Code);
+    loopCoefficients(settings.pllNoiseBandwidth, settings.pllDampingRatio, 0.25, tau1Carr, tau2Carr);
+    fllGain = 4 * settings.fllNoiseBandwidth * periodTime;  // First order loop: Bn = gain / (4 T)
+
+    // Strongest signals first (SoftGNSS preRun)
+    std::vector<int> prns;
+    for (int PRN : settings.satMask) {
+        if (acqResults.acquired[PRN]) {
+            prns.push_back(PRN);
+        }
+    }
+    std::stable_sort(prns.begin(), prns.end(),
+                     [&](int a, int b) { return acqResults.peakMetric[a] > acqResults.peakMetric[b]; });
+    if (prns.size() > static_cast<size_t>(settings.numberOfChannels)) {
+        prns.resize(settings.numberOfChannels);
+    }
+    numChannels = prns.size();
+    numLanes = (numChannels + trackingLanes - 1) / trackingLanes * trackingLanes;
+
+    carrPhase.assign(numLanes, 0.0);
+    carrFreq.assign(numLanes, 0.0);
+    carrFreqBasis.assign(numLanes, 0.0);
+    codePhase.assign(numLanes, 0.0);
+    codeFreq.assign(numLanes, 0.0);
+    codeFreqInit.assign(numLanes, 0.0);
+    oldCarrNco.assign(numLanes, 0.0);
+    oldCarrError.assign(numLanes, 0.0);
+    oldCodeNco.assign(numLanes, 0.0);
+    oldCodeError.assign(numLanes, 0.0);
+    oldIP.assign(numLanes, 0.0);
+    oldQP.assign(numLanes, 0.0);
+    correlations.assign(6 * size_t(numLanes), 0.0);
+    periodStart.assign(numLanes, 0);
+    partialPeriod.assign(numLanes, 0);
+    carrRe.assign(numLanes, 0.0f);
+    carrIm.assign(numLanes, 0.0f);
+    stepRe.assign(numLanes, 0.0f);
+    stepIm.assign(numLanes, 0.0f);
+    laneCodePhase.assign(numLanes, 0.0f);
+    laneCodeStep.assign(numLanes, 0.0f);
+    laneCorrelations.assign(6 * size_t(numLanes), 0.0f);
+    tableOffset.assign(numLanes, 0);  // Padding lanes read the first table
+
+    // E/P/L table of every channel: entry h covers code phases [h, h + 1) / tableResolution,
+    // where the early and late replicas (dllCorrelatorSpacing = 1 / tableResolution chips before
+    // and after the prompt one) fall in the chips of entries h - 1 and h + 1. One chip of
+    // wrapped entries and 3 bytes of padding are kept after the period for the 4-byte gathers.
+    int entries = settings.codeLength * tableResolution;
+    tableStride = (entries + tableResolution + 3 + 63) / 64 * 64;
+    codeTables.assign(size_t(numChannels) * tableStride, 0);
+
+    tracks.resize(numChannels);
+    for (int c = 0; c < numChannels; ++c) {
+        int PRN = prns[c];
+        tracks[c].PRN = PRN;
+
+        const auto& chips = caCodeTable.chips.at(PRN);
+        auto chipAt = [&](int h) {
+            int chip = (h >= 0 ? h / tableResolution : -1) % settings.codeLength;
+            return chips[(chip + settings.codeLength) % settings.codeLength] < 0;
+        };
+        int8_t* table = codeTables.data() + size_t(c) * tableStride;
+        for (int h = 0; h < entries + tableResolution; ++h) {
+            table[h] = (chipAt(h - 1) ? earlyBit : 0) | (chipAt(h) ? promptBit : 0) | (chipAt(h + 1) ? lateBit : 0);
+        }
+        tableOffset[c] = c * tableStride;
+
+        // The code period found by the acquisition starts codeDelay samples into the signal
+        double doppler = acqResults.carrFreq[PRN] - settings.IF;
+        carrFreq[c] = carrFreqBasis[c] = acqResults.carrFreq[PRN];
+        codeFreq[c] = codeFreqInit[c] = codeFreqBasis * (1 + doppler / gpsL1Frequency);
+        codePhase[c] = std::fmod(codeLength - acqResults.codeDelay[PRN] * codeFreq[c] / samplingFreq, codeLength);
+        partialPeriod[c] = codePhase[c] > 0.0;
+        setCarrierStep(c);
+    }
+}
+
+void TrackingChannels::setCarrierStep(int channel) {
+    double omega = 2 * M_PI * carrFreq[channel] / samplingFreq;
+    stepRe[channel] = static_cast<float>(std::cos(omega));
+    stepIm[channel] = static_cast<float>(-std::sin(omega));
+}
+
+void TrackingChannels::process(const std::complex<float>* samples, size_t numSamples) {
+    processBlock(samples, numSamples);
+}
+
+void TrackingChannels::process(const std::complex<double>* samples, size_t numSamples) {
+    processBlock(samples, numSamples);
+}
+
+// The block is cut into segments that end at the next phasor reset or the next code epoch of any
+// channel. Every segment is one kernel call over all the channels; the channels whose epoch ends
+// the segment then close their code period.
+template <typename T>
+void TrackingChannels::processBlock(const std::complex<T>* samples, size_t numSamples) {
+    static const CorrelatorKernel<T> kernel = selectKernel<T>();
+    METRICS_STAGE(Tracking);
+    METRICS_COUNT(SamplesTracked, numSamples * numChannels);
+    if (numChannels == 0) {
+        sampleCount += numSamples;
+        return;
+    }
+
+    KernelLanes lanes = {numLanes, carrRe.data(), carrIm.data(), stepRe.data(), stepIm.data(),
+                         laneCodePhase.data(), laneCodeStep.data(), tableOffset.data(), codeTables.data(),
+                         laneCorrelations.data()};
+    std::vector<size_t> toEpoch(numChannels);
+
+    for (size_t pos = 0; pos < numSamples;) {
+        size_t count = std::min<size_t>(numSamples - pos, trackingResetInterval);
+        for (int c = 0; c < numChannels; ++c) {
+            double step = codeFreq[c] / samplingFreq;
+            toEpoch[c] = std::max<size_t>(1, static_cast<size_t>(std::ceil((codeLength - codePhase[c]) / step)));
+            count = std::min(count, toEpoch[c]);
+
+            double phase = 2 * M_PI * carrPhase[c];
+            carrRe[c] = static_cast<float>(std::cos(phase));
+            carrIm[c] = static_cast<float>(-std::sin(phase));
+            laneCodePhase[c] = static_cast<float>(codePhase[c] * tableResolution);
+            laneCodeStep[c] = static_cast<float>(step * tableResolution);
+        }
+
+        kernel(samples + pos, static_cast<int>(count), lanes);
+
+        for (int c = 0; c < numChannels; ++c) {
+            for (int k = 0; k < 6; ++k) {
+                correlations[size_t(k) * numLanes + c] += laneCorrelations[size_t(k) * numLanes + c];
+            }
+            carrPhase[c] += count * carrFreq[c] / samplingFreq;
+            carrPhase[c] -= std::floor(carrPhase[c]);
+            codePhase[c] += count * codeFreq[c] / samplingFreq;
+        }
+        pos += count;
+        sampleCount += count;
+
+        for (int c = 0; c < numChannels; ++c) {
+            if (toEpoch[c] == count) {
+                codePhase[c] -= codeLength;
+                closePeriod(c);
+            }
+        }
+    }
+}
+
+void TrackingChannels::closePeriod(int channel) {
+    double corr[6];
+    for (int k = 0; k < 6; ++k) {
+        corr[k] = correlations[size_t(k) * numLanes + channel];
+        correlations[size_t(k) * numLanes + channel] = 0.0;
+    }
+    size_t start = periodStart[channel];
+    periodStart[channel] = sampleCount;
+    if (partialPeriod[channel]) {
+        partialPeriod[channel] = 0;
+        return;
+    }
+    double iE = corr[0], qE = corr[1], iP = corr[2], qP = corr[3], iL = corr[4], qL = corr[5];
+
+    // FLL: cross/dot discriminator of consecutive prompts, insensitive to the navigation data bits
+    // (range +-1 / (4 periodTime)). It moves the carrier frequency the PLL works around.
+    double dot = oldIP[channel] * iP + oldQP[channel] * qP;
+    double cross = oldIP[channel] * qP - iP * oldQP[channel];
+    double freqError = dot != 0.0 ? std::atan(cross / dot) / (2 * M_PI * periodTime) : 0.0;
+    carrFreqBasis[channel] += fllGain * freqError;
+    oldIP[channel] = iP;
+    oldQP[channel] = qP;
+
+    // PLL: Costas discriminator, insensitive to the navigation data bits
+    double carrError = iP != 0.0 ? std::atan(qP / iP) / (2 * M_PI) : 0.0;
+    double carrNco = oldCarrNco[channel] + tau2Carr / tau1Carr * (carrError - oldCarrError[channel])
+                   + carrError * (periodTime / tau1Carr);
+    oldCarrNco[channel] = carrNco;
+    oldCarrError[channel] = carrError;
+
+    // DLL: normalized early minus late envelope
+    double early = std::hypot(iE, qE), late = std::hypot(iL, qL);
+    double codeError = early + late > 0.0 ? (early - late) / (early + late) : 0.0;
+    double codeNco = oldCodeNco[channel] + tau2Code / tau1Code * (codeError - oldCodeError[channel])
+                   + codeError * (periodTime / tau1Code);
+    oldCodeNco[channel] = codeNco;
+    oldCodeError[channel] = codeError;
+
+    ChannelTrack& track = tracks[channel];
+    track.absoluteSample.push_back(start);
+    track.codeFreq.push_back(codeFreq[channel]);
+    track.carrFreq.push_back(carrFreq[channel]);
+    track.I_E.push_back(iE);
+    track.I_P.push_back(iP);
+    track.I_L.push_back(iL);
+    track.Q_E.push_back(qE);
+    track.Q_P.push_back(qP);
+    track.Q_L.push_back(qL);
+    track.dllDiscr.push_back(codeError);
+    track.dllDiscrFilt.push_back(codeNco);
+    track.pllDiscr.push_back(carrError);
+    track.pllDiscrFilt.push_back(carrNco);
+    track.fllDiscr.push_back(freqError);
+
+    carrFreq[channel] = carrFreqBasis[channel] + carrNco;
+    codeFreq[channel] = codeFreqInit[channel] - codeNco;
+    setCarrierStep(channel);
+}
+
+std::vector<ChannelTrack> trackGpsL1C(const Settings& settings, const SampleSource& source,
+                                      const AcqResults& acqResults) {
+    TrackingChannels channels(settings, acqResults);
+    size_t samplesPerCode = static_cast<size_t>(
+        std::round(settings.samplingFreq * settings.codeLength / settings.codeFreqBasis));
+    size_t numSamples = std::min(source.size(), static_cast<size_t>(settings.msToProcess * 1e-3 * settings.samplingFreq));
+
+    std::vector<std::complex<float>> block(samplesPerCode);
+    for (size_t first = 0; first < numSamples; first += samplesPerCode) {
+        size_t count = std::min(samplesPerCode, numSamples - first);
+        source.read<float>(first, count, block.data());
+        channels.process(block.data(), count);
+    }
+    return channels.results();
+}
@@ -0,0 +1,100 @@
+#ifndef TRACKING_GPS_H
+#define TRACKING_GPS_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SettingsGps.h"
+#include "Acquisition.h"
+#include "SampleSource.h"
+
+// Channels processed by one vector pass of the correlator kernel (channel arrays are padded to it)
+constexpr int trackingLanes = 16;
+
+// Samples correlated in single precision between exact carrier phasor resets
+constexpr int trackingResetInterval = 1024;
+
+// Tracking loop outputs of one channel, one entry per code period (SoftGNSS trackResults)
+struct ChannelTrack {
+    int PRN = 0;
+    std::vector<size_t> absoluteSample;  // Input sample where the code period starts
+    std::vector<double> codeFreq;        // Code frequency used over the period [Hz]
+    std::vector<double> carrFreq;        // Carrier frequency used over the period [Hz]
+    std::vector<double> I_E, I_P, I_L, Q_E, Q_P, Q_L;
+    std::vector<double> dllDiscr, dllDiscrFilt;  // Code discriminator and code NCO [chips], [Hz]
+    std::vector<double> pllDiscr, pllDiscrFilt;  // Carrier discriminator [cycles] and carrier NCO [Hz]
+    std::vector<double> fllDiscr;                // Frequency discriminator [Hz]
+
+    // Phase lock indicator over the last periods: (sum I_P^2 - sum Q_P^2) / (sum I_P^2 + sum Q_P^2),
+    // close to 1 when the PLL is locked
+    double phaseLockIndicator(size_t periods) const;
+};
+
+// Early/prompt/late correlators and DLL/PLL loops (the PLL aided by an FLL) of every channel,
+// run together. The channel state is kept as a structure of arrays, so one vector pass over a
+// block of samples updates trackingLanes channels at a time: each sample is loaded once,
+// broadcast and correlated with the carrier and code replicas of all the channels of the pass.
+// The three code replicas come from one table lookup per sample and channel (the E/P/L signs of
+// every dllCorrelatorSpacing of a chip) and are applied as sign flips. Channels close their code
+// period (and update their loops) at their own epochs, anywhere inside a block.
+class TrackingChannels {
+public:
+    // Assign the acquired PRNs of acqResults, strongest peak metric first, to at most
+    // settings.numberOfChannels channels. Sample 0 of the tracked signal is sample 0 of the
+    // acquisition signal.
+    TrackingChannels(const Settings& settings, const AcqResults& acqResults);
+
+    size_t size() const { return tracks.size(); }
+
+    // Track over the next numSamples input samples (any block length)
+    void process(const std::complex<float>* samples, size_t numSamples);
+    void process(const std::complex<double>* samples, size_t numSamples);
+
+    size_t samplesProcessed() const { return sampleCount; }
+
+    // Results of every channel; the first, partial, code period of a channel is not reported
+    const std::vector<ChannelTrack>& results() const { return tracks; }
+
+private:
+    template <typename T>
+    void processBlock(const std::complex<T>* samples, size_t numSamples);
+
+    // Close the code period of a channel: discriminators, loop filters and results
+    void closePeriod(int channel);
+
+    void setCarrierStep(int channel);
+
+    double samplingFreq, codeFreqBasis, codeLength, periodTime;
+    double tau1Code, tau2Code, tau1Carr, tau2Carr, fllGain;
+    int numChannels, numLanes;
+    int tableResolution, tableStride;  // Table entries per chip, bytes per channel table
+    size_t sampleCount = 0;
+
+    // Channel state, numLanes entries each (lanes past numChannels are padding)
+    std::vector<double> carrPhase;      // [cycles]
+    std::vector<double> carrFreq, carrFreqBasis;
+    std::vector<double> codePhase;      // Chips into the current code period
+    std::vector<double> codeFreq, codeFreqInit;
+    std::vector<double> oldCarrNco, oldCarrError, oldCodeNco, oldCodeError;
+    std::vector<double> oldIP, oldQP;   // Prompt of the previous period, for the FLL
+    std::vector<double> correlations;   // 6 x numLanes: I_E, Q_E, I_P, Q_P, I_L, Q_L of the period
+    std::vector<size_t> periodStart;
+    std::vector<uint8_t> partialPeriod;
+
+    // Single precision lanes handed to the correlator kernel
+    std::vector<float> carrRe, carrIm, stepRe, stepIm;
+    std::vector<float> laneCodePhase, laneCodeStep;
+    std::vector<float> laneCorrelations;
+    std::vector<int32_t> tableOffset;
+    std::vector<int8_t> codeTables;
+
+    std::vector<ChannelTrack> tracks;
+};
+
+// Track the signals acquired in acqResults over settings.msToProcess ms of source, read in code
+// period blocks
+std::vector<ChannelTrack> trackGpsL1C(const Settings& settings, const SampleSource& source,
+                                      const AcqResults& acqResults);
+
+#endif // TRACKING_GPS_H
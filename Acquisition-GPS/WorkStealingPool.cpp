@@ -0,0 +1,130 @@
+/*
+########################################################################
+# WorkStealingPool.cpp:
+# Work-stealing thread pool for the acquisition search
+#
+#  Project:        sw-rcvr-c++
+#  File:           WorkStealingPool.cpp
+#
+########################################################################
+*/
+
+#include <algorithm>
+#include "WorkStealingPool.h"
+
+WorkStealingPool::WorkStealingPool(int numThreads) {
+    if (numThreads <= 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (int i = 0; i < numThreads; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (int i = 0; i < numThreads; ++i) {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::run(size_t numTiles, const std::function<void(size_t, int)>& task) {
+    if (numTiles == 0) {
+        return;
+    }
+
+    // Seed every worker with a contiguous range of tiles
+    size_t numWorkers = workers.size();
+    for (size_t w = 0; w < numWorkers; ++w) {
+        size_t begin = numTiles * w / numWorkers;
+        size_t end = numTiles * (w + 1) / numWorkers;
+        std::lock_guard<std::mutex> lock(queues[w]->mutex);
+        for (size_t tile = begin; tile < end; ++tile) {
+            queues[w]->tiles.push_back(tile);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    currentTask = &task;
+    firstError = nullptr;
+    pendingTiles = numTiles;
+    busyWorkers = static_cast<int>(numWorkers);
+    ++batchId;
+    wakeWorkers.notify_all();
+
+    batchDone.wait(lock, [this] { return busyWorkers == 0; });
+    currentTask = nullptr;
+
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
+
+bool WorkStealingPool::nextTile(int workerIndex, size_t& tile) {
+    // Own queue first (LIFO keeps the most recent tile's data in cache)
+    {
+        WorkerQueue& own = *queues[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tiles.empty()) {
+            tile = own.tiles.back();
+            own.tiles.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest tile of another worker
+    size_t numWorkers = queues.size();
+    for (size_t offset = 1; offset < numWorkers; ++offset) {
+        WorkerQueue& victim = *queues[(workerIndex + offset) % numWorkers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tiles.empty()) {
+            tile = victim.tiles.front();
+            victim.tiles.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(int workerIndex) {
+    size_t seenBatch = 0;
+
+    while (true) {
+        const std::function<void(size_t, int)>* task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeWorkers.wait(lock, [&] { return stopping || batchId != seenBatch; });
+            if (stopping) {
+                return;
+            }
+            seenBatch = batchId;
+            task = currentTask;
+        }
+
+        size_t tile;
+        while (pendingTiles > 0 && nextTile(workerIndex, tile)) {
+            try {
+                (*task)(tile, workerIndex);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!firstError) {
+                    firstError = std::current_exception();
+                }
+            }
+            --pendingTiles;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0) {
+            batchDone.notify_all();
+        }
+    }
+}
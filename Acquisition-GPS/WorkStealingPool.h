@@ -0,0 +1,57 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool running batches of independent tiles. Each worker owns a deque of
+// tile indices, seeded with a contiguous range; it pops from the back of its own deque and,
+// once empty, steals from the front of the others.
+class WorkStealingPool {
+public:
+    // numThreads <= 0 uses every hardware thread
+    explicit WorkStealingPool(int numThreads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int size() const { return static_cast<int>(workers.size()); }
+
+    // Run task(tileIndex, workerIndex) for every tile in [0, numTiles) and wait for all of them.
+    // workerIndex is in [0, size()) so tasks can use per-worker scratch state. The first
+    // exception thrown by a task is rethrown here once the batch has drained.
+    void run(size_t numTiles, const std::function<void(size_t, int)>& task);
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<size_t> tiles;
+    };
+
+    void workerLoop(int workerIndex);
+    bool nextTile(int workerIndex, size_t& tile);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+    std::mutex mutex;
+    std::condition_variable wakeWorkers;
+    std::condition_variable batchDone;
+    const std::function<void(size_t, int)>* currentTask = nullptr;
+    size_t batchId = 0;
+    std::atomic<size_t> pendingTiles{0};
+    int busyWorkers = 0;
+    bool stopping = false;
+    std::exception_ptr firstError;
+};
+
+#endif // WORK_STEALING_POOL_H
@@ -4,37 +4,210 @@
 #include <string>
 #include <filesystem>
 #include <complex>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
 #include "SettingsGps.h"      // Encabezado para la clase Settings
 #include "Acquisition.h"  // Encabezado para la función de adquisición
+#include "FftPlanCache.h" // Caché de planes FFTW
+#include "SampleSource.h" // Lectura de muestras mapeadas en memoria
+#include "AcquisitionHints.h" // Resultados guardados para el arranque en caliente
+#include "SampleCache.h" // Caché de la señal preprocesada
+#include "StreamingAcquisition.h" // Adquisición continua desde una FIFO o un socket
+#include "Tracking.h" // Seguimiento de los satélites adquiridos
+#include "Metrics.h" // Tiempos por etapa y contadores
+#include "BatchAcquisition.h" // Adquisición en lote de una lista de grabaciones
+#include "AcquisitionProfile.h" // Ajustes medidos en esta máquina por AutotuneAcquisition
 
 namespace fs = std::filesystem;
 
+// Adquisición en caliente si hay pistas; búsqueda completa si no las hay o si no se adquiere
+// ningún satélite con ellas. signal es la entrada leída o la señal preprocesada de la caché
+template <typename Signal>
+AcqResults acquireSignal(const Settings& settings, const Signal& signal, const std::vector<AcquisitionHint>& hints) {
+    if (!hints.empty()) {
+        AcqResults acqResults = reacquireGpsL1C(settings, signal, hints);
+        for (const AcquisitionHint& hint : hints) {
+            if (acqResults.acquired[hint.PRN]) {
+                if (settings.acqDumpResults) {
+                    acqResults.dump(settings, acquisitionOutputDir(settings));
+                }
+                return acqResults;
+            }
+        }
+        std::cout << "Warm start found no satellite, searching all of them" << std::endl;
+    }
+    return acquisitionGpsL1C(settings, signal);
+}
+
+// Señal de la caché si está configurada (se regenera si no coincide con los ajustes); si no, o
+// si la caché no se puede escribir ni mapear, solo las muestras de entrada que usa la adquisición
+template <typename T>
+AcqResults acquire(const Settings& settings, const SampleSource& source, const std::vector<AcquisitionHint>& hints) {
+    if (!settings.sampleCacheFile.empty()) {
+        std::optional<SampleCache> cache;
+        try {
+            cache.emplace(settings, source);
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: sample cache not used (" << e.what() << "), reading the input file" << std::endl;
+        }
+        if (cache) {
+            if (cache->rebuilt()) {
+                std::cout << "Sample cache written to " << settings.sampleCacheFile << std::endl;
+            }
+            return acquireSignal(settings, cache->signal<T>(), hints);
+        }
+    }
+    return acquireSignal(settings, source.read<T>(0, acquisitionSampleCount(settings)), hints);
+}
+
+// Adquisición continua: una línea por búsqueda y el resumen de latencia y memoria al final
+void runStreaming(const Settings& settings) {
+    std::cout << "Streaming from " << settings.streamInput << std::endl;
+    StreamStatistics stats = streamingAcquisition(settings, [&](const StreamAcquisition& acquisition) {
+        std::cout << "t = " << acquisition.streamTimeMs << " ms: PRN";
+        for (int PRN : settings.satMask) {
+            if (acquisition.acqResults.acquired[PRN]) {
+                std::cout << " " << PRN;
+            }
+        }
+        std::cout << " (latency " << acquisition.latencyMs << " ms)" << std::endl;
+    });
+
+    std::cout << "Stream ended: " << stats.blocksReceived << " blocks received, " << stats.blocksDropped
+              << " dropped, " << stats.runs << " searches, " << stats.skippedRuns << " skipped" << std::endl;
+    std::cout << "Latency: mean " << stats.meanLatencyMs << " ms, max " << stats.maxLatencyMs << " ms" << std::endl;
+    std::cout << "Memory: " << stats.memoryBytes / 1024 << " KiB allocated, peak ring buffer use "
+              << stats.peakBufferedBytes / 1024 << " KiB" << std::endl;
+}
+
+// Adquisición en lote: una línea por grabación, los errores y el resumen al final
+void runBatch(const Settings& settings) {
+    std::vector<BatchJob> jobs = loadBatchManifest(settings.batchManifest, settings);
+    std::cout << "Batch of " << jobs.size() << " recordings from " << settings.batchManifest << std::endl;
+    BatchStatistics stats = batchAcquisition(settings, jobs, [&](const BatchFileResult& result) {
+        const Settings& jobSettings = result.job->settings;
+        std::cout << "[" << result.index + 1 << "/" << jobs.size() << "] " << jobSettings.inputFile;
+        if (result.failed) {
+            std::cout << ": error (manifest line " << result.job->line << "): " << result.error << std::endl;
+            return;
+        }
+        std::cout << ": PRN";
+        for (int PRN : jobSettings.satMask) {
+            if (result.acqResults.acquired[PRN]) {
+                std::cout << " " << PRN;
+            }
+        }
+        std::cout << " (" << result.searchSeconds << " s)" << std::endl;
+    });
+
+    std::cout << "Batch complete: " << stats.jobs << " recordings, " << stats.failed << " failed, " << stats.acquired
+              << " satellites acquired in " << stats.seconds << " s" << std::endl;
+    std::cout << "Input: " << stats.bytesRead / 1e6 / stats.seconds << " MB/s, searches waited "
+              << stats.loadWaitSeconds << " s for input" << std::endl;
+    std::cout << "Results in " << batchOutputPath(settings) << std::endl;
+}
+
+// Seguimiento de los satélites adquiridos: resumen por canal y velocidad frente al tiempo real
+void track(const Settings& settings, const SampleSource& source, const AcqResults& acqResults) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ChannelTrack> tracks = trackGpsL1C(settings, source, acqResults);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double signalTime = std::min(source.size() / settings.samplingFreq, settings.msToProcess * 1e-3);
+
+    std::cout << "Tracking complete: " << tracks.size() << " channels, " << signalTime / elapsed
+              << " x real time" << std::endl;
+    for (const ChannelTrack& channel : tracks) {
+        if (!channel.carrFreq.empty()) {
+            std::cout << "PRN " << channel.PRN << ": Doppler " << channel.carrFreq.back() - settings.IF
+                      << " Hz, code rate offset " << channel.codeFreq.back() - settings.codeFreqBasis
+                      << " Hz, phase lock " << channel.phaseLockIndicator(100) << std::endl;
+        }
+    }
+}
+
 int main() {
     try {
         // Inicializar configuración
         Settings settings;
 
-        // Leer archivo de entrada
-        std::string npyFile = settings.inputFile + "." + std::to_string(settings.msToProcess);
-        std::string npyFileWithExtension = npyFile + ".npy";
-        std::vector<std::complex<double>> inputSignal;
+        // Perfil de esta máquina: tamaño de FFT, precisión, hilos y bloques elegidos por AutotuneAcquisition
+        if (!settings.acqProfileFile.empty() && loadAcquisitionProfile(settings.acqProfileFile, settings)) {
+            std::cout << "Acquisition profile for " << profileHostName() << " loaded from " << settings.acqProfileFile
+                      << std::endl;
+        }
 
-        if (fs::exists(npyFileWithExtension)) {
-            // Cargar datos del archivo .npy
-            inputSignal = loadNpyFile(npyFileWithExtension);
-        } else {
-            // Cargar datos del archivo original
-            inputSignal = loadTxtFile(settings.inputFile, 
-                                      static_cast<size_t>(round(settings.msToProcess * 1e-3 * settings.samplingFreq)));
+        // Modo por lotes: lista de grabaciones con sus propios ajustes
+        if (!settings.batchManifest.empty()) {
+            runBatch(settings);
+            FftPlanCache::instance().release();
+            if (!settings.metricsFile.empty()) {
+                writeMetrics(settings.metricsFile);
+            }
+            std::cout << "Done!" << std::endl;
+            return EXIT_SUCCESS;
+        }
 
-            // Guardar como .npy para uso futuro
-            saveNpyFile(npyFileWithExtension, inputSignal);
+        // Modo continuo: la entrada llega por una FIFO o un socket en lugar de un archivo completo
+        if (!settings.streamInput.empty()) {
+            runStreaming(settings);
+            FftPlanCache::instance().release();
+            if (!settings.metricsFile.empty()) {
+                writeMetrics(settings.metricsFile);
+            }
+            std::cout << "Done!" << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        // Mapear el archivo de entrada: solo se convierten las muestras que usa la adquisición,
+        // directamente a la precisión de la búsqueda
+        SampleSource source(settings.inputFile, parseSampleFormat(settings.dataType));
+
+        // Las muestras que faltan se leerían como ceros: rechazar grabaciones demasiado cortas
+        size_t neededSamples = acquisitionSampleCount(settings);
+        if (source.size() < neededSamples) {
+            throw std::runtime_error("Recording too short: " + settings.inputFile + " has " +
+                                     std::to_string(source.size()) + " samples, " + std::to_string(neededSamples) +
+                                     " needed");
+        }
+
+        // Pistas del arranque en caliente: lista de visibilidad o resultados de la ejecución anterior
+        std::vector<AcquisitionHint> hints;
+        if (settings.acqWarmStart) {
+            if (!settings.acqVisibilityFile.empty()) {
+                hints = loadVisibilityList(settings.acqVisibilityFile, settings);
+            } else if (!settings.acqResultsFile.empty() && fs::exists(settings.acqResultsFile)) {
+                hints = loadAcquisitionResults(settings.acqResultsFile, settings);
+            }
         }
 
         // Ejecutar adquisición
         if (settings.signal.find("gpsl1c") != std::string::npos) {
-            AcqResults acqResultsGpsL1C = acquisitionGpsL1C(settings, inputSignal);
+            AcqResults acqResultsGpsL1C = settings.acqPrecision == "float"
+                ? acquire<float>(settings, source, hints)
+                : acquire<double>(settings, source, hints);
             std::cout << "Acquisition complete!" << std::endl;
+            if (settings.acqDumpResults) {
+                std::cout << "Results in " << acquisitionOutputDir(settings) << " (figures: PlotAcquisition)" << std::endl;
+            }
+
+            // Guardar resultados para el siguiente arranque en caliente
+            if (!settings.acqResultsFile.empty()) {
+                saveAcquisitionResults(settings.acqResultsFile, settings, acqResultsGpsL1C);
+            }
+
+            // Seguimiento durante msToProcess ms a partir de los resultados de la adquisición
+            if (settings.msToProcess > 0) {
+                track(settings, source, acqResultsGpsL1C);
+            }
+        }
+
+        // Liberar planes FFTW y guardar wisdom
+        FftPlanCache::instance().release();
+
+        // Totales de tiempos y contadores de la ejecución
+        if (!settings.metricsFile.empty()) {
+            writeMetrics(settings.metricsFile);
         }
 
     } catch (const std::exception& e) {
@@ -2,6 +2,8 @@
 #define MATPLOTLIBCPP_H
 
 #include <Python.h>
+#include <cstdlib>
+#include <map>
 #include <vector>
 #include <string>
 #include <iostream>
@@ -9,123 +11,218 @@
 namespace matplotlibcpp {
 
     // Función para inicializar Python
-    void init() {
-        Py_Initialize();
+    inline void init() {
+        if (!Py_IsInitialized()) {
+            Py_Initialize();
+        }
     }
 
     // Función para finalizar la ejecución de Python
-    void finalize() {
+    inline void finalize() {
         Py_Finalize();
     }
 
-    // Función para crear una figura
-    void figure() {
-        PyObject* matplotlib = PyImport_ImportModule("matplotlib.pyplot");
-        if (!matplotlib) {
-            std::cerr << "Error al importar matplotlib!" << std::endl;
-            return;
+    // Función para crear una lista de datos en Python desde un vector de C++
+    inline PyObject* PyList_FromVector(const std::vector<double>& vec) {
+        PyObject* pyList = PyList_New(vec.size());
+        for (size_t i = 0; i < vec.size(); ++i) {
+            PyList_SetItem(pyList, i, PyFloat_FromDouble(vec[i]));
         }
-        PyObject* func = PyObject_GetAttrString(matplotlib, "figure");
+        return pyList;
+    }
+
+    // Módulo matplotlib.pyplot, importado una sola vez. Sin pantalla se usa el backend Agg
+    // (solo archivos)
+    inline PyObject* pyplot() {
+        static PyObject* module = [] {
+            init();
+            if (!std::getenv("DISPLAY")) {
+                PyObject* matplotlib = PyImport_ImportModule("matplotlib");
+                if (matplotlib) {
+                    PyObject_CallMethod(matplotlib, "use", "s", "Agg");
+                    Py_DECREF(matplotlib);
+                }
+            }
+            PyObject* pyplotModule = PyImport_ImportModule("matplotlib.pyplot");
+            if (!pyplotModule) {
+                PyErr_Print();
+                std::cerr << "Error al importar matplotlib!" << std::endl;
+            }
+            return pyplotModule;
+        }();
+        return module;
+    }
+
+    // Llamar a la función name de pyplot; args y kwargs pasan a ser propiedad de la llamada
+    inline PyObject* call(const char* name, PyObject* args = nullptr, PyObject* kwargs = nullptr) {
+        PyObject* result = nullptr;
+        PyObject* module = pyplot();
+        PyObject* func = module ? PyObject_GetAttrString(module, name) : nullptr;
         if (func && PyCallable_Check(func)) {
-            PyObject_CallObject(func, NULL);
+            if (!args) {
+                args = PyTuple_New(0);
+            }
+            result = PyObject_Call(func, args, kwargs);
+            if (!result) {
+                PyErr_Print();
+            }
         }
         Py_XDECREF(func);
-        Py_XDECREF(matplotlib);
+        Py_XDECREF(args);
+        Py_XDECREF(kwargs);
+        return result;
     }
 
-    // Función para graficar líneas
-    void plot(const std::vector<double>& x, const std::vector<double>& y) {
-        PyObject* matplotlib = PyImport_ImportModule("matplotlib.pyplot");
-        if (!matplotlib) {
-            std::cerr << "Error al importar matplotlib!" << std::endl;
-            return;
+    // Argumentos con nombre: "True"/"False" se pasan como booleanos, el resto como texto
+    inline PyObject* keywordArgs(const std::map<std::string, std::string>& keywords) {
+        PyObject* kwargs = PyDict_New();
+        for (const auto& [key, value] : keywords) {
+            if (value == "True" || value == "False") {
+                PyDict_SetItemString(kwargs, key.c_str(), value == "True" ? Py_True : Py_False);
+            } else {
+                PyObject* pyValue = PyUnicode_FromString(value.c_str());
+                PyDict_SetItemString(kwargs, key.c_str(), pyValue);
+                Py_DECREF(pyValue);
+            }
         }
+        return kwargs;
+    }
 
-        PyObject* func = PyObject_GetAttrString(matplotlib, "plot");
-        if (func && PyCallable_Check(func)) {
-            PyObject* args = PyTuple_Pack(2, 
-                PyList_FromVector(x), 
-                PyList_FromVector(y));
-            PyObject_CallObject(func, args);
-            Py_XDECREF(args);
+    // Función para crear una figura
+    inline void figure() {
+        Py_XDECREF(call("figure"));
+    }
+
+    // Función para graficar líneas
+    inline void plot(const std::vector<double>& x, const std::vector<double>& y) {
+        PyObject* args = PyTuple_New(2);
+        PyTuple_SetItem(args, 0, PyList_FromVector(x));
+        PyTuple_SetItem(args, 1, PyList_FromVector(y));
+        Py_XDECREF(call("plot", args));
+    }
+
+    // Función para graficar barras
+    inline void bar(const std::vector<double>& x, const std::vector<double>& height) {
+        PyObject* args = PyTuple_New(2);
+        PyTuple_SetItem(args, 0, PyList_FromVector(x));
+        PyTuple_SetItem(args, 1, PyList_FromVector(height));
+        Py_XDECREF(call("bar", args));
+    }
+
+    // Convertir una lista (anidada) en un array de numpy; se queda con la referencia de list
+    inline PyObject* toArray(PyObject* list) {
+        static PyObject* numpy = PyImport_ImportModule("numpy");
+        PyObject* array = numpy ? PyObject_CallMethod(numpy, "asarray", "O", list) : nullptr;
+        Py_DECREF(list);
+        if (!array) {
+            PyErr_Print();
         }
-        Py_XDECREF(func);
-        Py_XDECREF(matplotlib);
+        return array;
     }
 
-    // Función para mostrar el gráfico
-    void show() {
-        PyObject* matplotlib = PyImport_ImportModule("matplotlib.pyplot");
-        if (!matplotlib) {
-            std::cerr << "Error al importar matplotlib!" << std::endl;
+    // Superficie 3D z[i][j] en (x[i], y[j]) sobre unos ejes 3D nuevos de la figura actual
+    inline void plot_surface(const std::vector<double>& x, const std::vector<double>& y,
+                             const std::vector<std::vector<double>>& z,
+                             const std::map<std::string, std::string>& keywords = {}) {
+        PyObject* fig = call("gcf");
+        if (!fig) {
             return;
         }
-        PyObject* func = PyObject_GetAttrString(matplotlib, "show");
-        if (func && PyCallable_Check(func)) {
-            PyObject_CallObject(func, NULL);
+        PyObject* subplotKwargs = keywordArgs({{"projection", "3d"}});
+        PyObject* subplotArgs = Py_BuildValue("(i)", 111);
+        PyObject* addSubplot = PyObject_GetAttrString(fig, "add_subplot");
+        PyObject* axes = addSubplot ? PyObject_Call(addSubplot, subplotArgs, subplotKwargs) : nullptr;
+        Py_XDECREF(addSubplot);
+        Py_DECREF(subplotArgs);
+        Py_DECREF(subplotKwargs);
+        Py_DECREF(fig);
+        if (!axes) {
+            PyErr_Print();
+            return;
         }
-        Py_XDECREF(func);
-        Py_XDECREF(matplotlib);
-    }
 
-    // Función para establecer el título del gráfico
-    void title(const std::string& title) {
-        PyObject* matplotlib = PyImport_ImportModule("matplotlib.pyplot");
-        if (!matplotlib) {
-            std::cerr << "Error al importar matplotlib!" << std::endl;
-            return;
+        // Mallas X, Y y Z como arrays 2D
+        PyObject* X = PyList_New(x.size());
+        PyObject* Y = PyList_New(x.size());
+        PyObject* Z = PyList_New(x.size());
+        for (size_t i = 0; i < x.size(); ++i) {
+            PyList_SetItem(X, i, PyList_FromVector(std::vector<double>(y.size(), x[i])));
+            PyList_SetItem(Y, i, PyList_FromVector(y));
+            PyList_SetItem(Z, i, PyList_FromVector(z[i]));
         }
-        PyObject* func = PyObject_GetAttrString(matplotlib, "title");
-        if (func && PyCallable_Check(func)) {
-            PyObject* arg = PyUnicode_FromString(title.c_str());
-            PyObject_CallObject(func, PyTuple_Pack(1, arg));
-            Py_XDECREF(arg);
+        X = toArray(X);
+        Y = toArray(Y);
+        Z = toArray(Z);
+
+        PyObject* surface = PyObject_GetAttrString(axes, "plot_surface");
+        if (surface && X && Y && Z) {
+            PyObject* args = PyTuple_New(3);
+            PyTuple_SetItem(args, 0, X);
+            PyTuple_SetItem(args, 1, Y);
+            PyTuple_SetItem(args, 2, Z);
+            PyObject* kwargs = keywordArgs(keywords);
+            PyObject* result = PyObject_Call(surface, args, kwargs);
+            if (!result) {
+                PyErr_Print();
+            }
+            Py_XDECREF(result);
+            Py_DECREF(args);
+            Py_DECREF(kwargs);
+            Py_DECREF(surface);
+        } else {
+            Py_XDECREF(surface);
+            Py_XDECREF(X);
+            Py_XDECREF(Y);
+            Py_XDECREF(Z);
         }
-        Py_XDECREF(func);
-        Py_XDECREF(matplotlib);
+        Py_DECREF(axes);
+    }
+
+    // Función para mostrar el gráfico
+    inline void show() {
+        Py_XDECREF(call("show"));
+    }
+
+    // Función para guardar la figura actual en un archivo
+    inline void save(const std::string& filename) {
+        Py_XDECREF(call("savefig", Py_BuildValue("(s)", filename.c_str())));
+    }
+
+    // Función para cerrar la figura actual
+    inline void close() {
+        Py_XDECREF(call("close"));
+    }
+
+    // Función para establecer el título del gráfico
+    inline void title(const std::string& title) {
+        Py_XDECREF(call("title", Py_BuildValue("(s)", title.c_str())));
     }
 
     // Función para definir etiquetas en los ejes
-    void xlabel(const std::string& label) {
-        PyObject* matplotlib = PyImport_ImportModule("matplotlib.pyplot");
-        if (!matplotlib) {
-            std::cerr << "Error al importar matplotlib!" << std::endl;
-            return;
-        }
-        PyObject* func = PyObject_GetAttrString(matplotlib, "xlabel");
-        if (func && PyCallable_Check(func)) {
-            PyObject* arg = PyUnicode_FromString(label.c_str());
-            PyObject_CallObject(func, PyTuple_Pack(1, arg));
-            Py_XDECREF(arg);
-        }
-        Py_XDECREF(func);
-        Py_XDECREF(matplotlib);
+    inline void xlabel(const std::string& label) {
+        Py_XDECREF(call("xlabel", Py_BuildValue("(s)", label.c_str())));
     }
 
     // Función para definir etiquetas en los ejes
-    void ylabel(const std::string& label) {
-        PyObject* matplotlib = PyImport_ImportModule("matplotlib.pyplot");
-        if (!matplotlib) {
-            std::cerr << "Error al importar matplotlib!" << std::endl;
-            return;
-        }
-        PyObject* func = PyObject_GetAttrString(matplotlib, "ylabel");
-        if (func && PyCallable_Check(func)) {
-            PyObject* arg = PyUnicode_FromString(label.c_str());
-            PyObject_CallObject(func, PyTuple_Pack(1, arg));
-            Py_XDECREF(arg);
-        }
-        Py_XDECREF(func);
-        Py_XDECREF(matplotlib);
+    inline void ylabel(const std::string& label) {
+        Py_XDECREF(call("ylabel", Py_BuildValue("(s)", label.c_str())));
     }
 
-    // Función para crear una lista de datos en Python desde un vector de C++
-    PyObject* PyList_FromVector(const std::vector<double>& vec) {
-        PyObject* pyList = PyList_New(vec.size());
-        for (size_t i = 0; i < vec.size(); ++i) {
-            PyList_SetItem(pyList, i, PyFloat_FromDouble(vec[i]));
-        }
-        return pyList;
+    // Función para mostrar la rejilla
+    inline void grid(bool visible, const std::string& linestyle = "-", double alpha = 1.0) {
+        PyObject* kwargs = PyDict_New();
+        PyObject* pyLinestyle = PyUnicode_FromString(linestyle.c_str());
+        PyObject* pyAlpha = PyFloat_FromDouble(alpha);
+        PyDict_SetItemString(kwargs, "linestyle", pyLinestyle);
+        PyDict_SetItemString(kwargs, "alpha", pyAlpha);
+        Py_DECREF(pyLinestyle);
+        Py_DECREF(pyAlpha);
+        Py_XDECREF(call("grid", Py_BuildValue("(O)", visible ? Py_True : Py_False), kwargs));
+    }
+
+    // Función para fijar los límites del eje y
+    inline void ylim(double bottom, double top) {
+        Py_XDECREF(call("ylim", Py_BuildValue("(dd)", bottom, top)));
     }
 }
 